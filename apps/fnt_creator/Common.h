@@ -23,15 +23,18 @@ struct PageConfig
     PageConfig()
     {
         fixed_width_alignment = false;
+        priority = 0;
         text = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ!№;%:?*()_+-=.,/|\"'@#$^&{}[] ";
     }
 	// 是否固定宽度对齐(按最大字符宽度)
     bool fixed_width_alignment;
+    // 字符归属优先级(codepoint_owner为priority时生效, 多个页面包含相同字符时由优先级最高的页面渲染该字符)
+    int priority;
     std::string text;
     std::vector<uint32_t> chars;
     std::vector<std::string> fonts;
 };
-AJSON(PageConfig, fixed_width_alignment, text, chars, fonts);
+AJSON(PageConfig, fixed_width_alignment, priority, text, chars, fonts);
 
 struct Position
 {
@@ -46,6 +49,8 @@ struct Position
     }
     float x;
     float y;
+
+    bool operator==(const Position&) const = default;
 };
 AJSON(Position, x, y);
 
@@ -65,6 +70,8 @@ struct LinearGradient
     std::vector<std::string> colors;
     // 颜色分布比例（默认线性分布）
     std::vector<float> pos;
+
+    bool operator==(const LinearGradient&) const = default;
 };
 AJSON(LinearGradient, begin, end, colors, pos);
 
@@ -80,6 +87,8 @@ struct TextEffect
 
     // 线性渐变参数
     LinearGradient linear_gradient;
+
+    bool operator==(const TextEffect&) const = default;
 };
 AJSON(TextEffect, effect_type, linear_gradient);
 
@@ -98,9 +107,45 @@ struct TextShadow
     std::string color;
     std::string blend_mode;
     //TextEffect effect;  // 阴影暂时不支持effect
+
+    bool operator==(const TextShadow&) const = default;
 };
 AJSON(TextShadow, offsetx, offsety, blur_radius, color, blend_mode);
 
+// 蒙版特效, 由字符填充覆盖率计算, 只作用于文字内部, 绘制在文字填充之上
+struct MaskEffect
+{
+    MaskEffect()
+    {
+        effect_type = "inner_shadow";
+        offsetx = 0;
+        offsety = 0;
+        blur_radius = 3.0f;
+        color = "#000000bf";
+        size = 4.0f;
+        angle = 120.0f;
+        highlight_color = "#ffffffbf";
+        shadow_color = "#000000bf";
+    }
+    // inner_shadow 内阴影, 文字外部区域模糊、偏移后投射到文字内部(offsetx, offsety, blur_radius, color)
+    // inner_glow   内发光, 从文字边缘向内的发光(blur_radius, color)
+    // bevel        斜面浮雕, 以文字内部到轮廓的距离为高度, 宽度 size 的斜面在光源方向 angle 下的高光及阴影(size, angle, highlight_color, shadow_color)
+    std::string effect_type;
+    int offsetx;
+    int offsety;
+    float blur_radius;
+    std::string color;
+    // 斜面宽度
+    float size;
+    // 光源方向(度), 0 为右侧, 逆时针
+    float angle;
+    std::string highlight_color;
+    std::string shadow_color;
+
+    bool operator==(const MaskEffect&) const = default;
+};
+AJSON(MaskEffect, effect_type, offsetx, offsety, blur_radius, color, size, angle, highlight_color, shadow_color);
+
 struct TextStyle
 {
     TextStyle()
@@ -112,6 +157,7 @@ struct TextStyle
         outline_thickness = 0;
         outline_thickness_render_scale = 2.0f;
         outline_color = "#ffffffff";
+        outline_position = "center";
     }
 
     // 文字大小
@@ -143,6 +189,13 @@ struct TextStyle
     TextEffect outline_effect;
     // 描边阴影
     std::vector<TextShadow> outline_shadows;
+    // 描边位置(render_engine 为 blob 时只支持 center)
+    // center  以轮廓为中心
+    // inside  描边与文字填充的交集, 绘制在文字之上
+    // outside 描边去除文字填充的部分
+    std::string outline_position;
+    // 蒙版特效, 按顺序叠加
+    std::vector<MaskEffect> mask_effects;
 };
 AJSON(TextStyle, 
     font_size,
@@ -158,14 +211,56 @@ AJSON(TextStyle,
     outline_color,
     outline_blend_mode,
     outline_effect,
-    outline_shadows
+    outline_shadows,
+    outline_position,
+    mask_effects
 );
 
+// 自动适配字体大小
+struct FitTo
+{
+    FitTo()
+    {
+        enabled = false;
+        max_pages = 1;
+        width = 1024;
+        height = 1024;
+        min_font_size = 8;
+        max_font_size = 200;
+        fit_outline = false;
+    }
+    // 开启后搜索能放入 max_pages 个 width x height 页面的最大字体大小
+    bool enabled;
+    // 最大页面数量(通道打包时为纹理数量)
+    int max_pages;
+    // 页面宽高
+    int width;
+    int height;
+    // 字体大小搜索范围
+    int min_font_size;
+    int max_font_size;
+    // 描边宽度是否随字体大小等比缩放
+    bool fit_outline;
+};
+AJSON(FitTo, enabled, max_pages, width, height, min_font_size, max_font_size, fit_outline);
+
 struct GenerateConfig
 {
     GenerateConfig()
     {
         use_gpu = true;
+        render_threads = 0;
+        render_memory_budget = 512;
+        render_engine = "canvas";
+        shadow_mode = "mask";
+        blur_engine = "skia";
+        blur_max_error = 0.0f;
+        outline_engine = "stroke";
+        render_mode = "bitmap";
+        sdf_spread = 4;
+        sdf_scale = 4;
+        output_format = "rgba";
+        channel_packing = false;
         spacing_horiz = 1;
         spacing_vert = 1;
         spacing_glyph_x = 1;
@@ -184,6 +279,12 @@ struct GenerateConfig
         is_NPOT = true;
         is_fully_wrapped_mode = true;
         max_width = 4096;
+        max_height = 0;
+        fitted_width = 0;
+        fitted_height = 0;
+        page_split_mode = "fill";
+        codepoint_owner = "first_page";
+        frequency_format = "counts";
 
         is_draw_debug = false;
         is_debug_draw_glyph_all_area = true;
@@ -197,6 +298,56 @@ struct GenerateConfig
     }
     // 使用gpu渲染
     bool use_gpu;
+    // CPU渲染线程数(<=0 使用CPU核心数, 1 单线程), 页面按水平条带拆分后并行绘制
+    int render_threads;
+    // CPU渲染时多个页面并行绘制, 同时存在的页面位图总内存上限(MB, <=0 不限制)
+    int render_memory_budget;
+    // 渲染方式
+    // canvas 直接绘制到页面(CPU渲染时按条带多线程绘制)
+    // sprite 每个字符并行绘制到独立的精灵图后按顺序合成到页面, 结果与线程数无关
+    //        非 SrcOver 混合模式只与字符自身的图层混合, 不与背景色及相邻字符混合
+    // blob   每个图层将页面(条带)所有字符合并为一个 SkTextBlob 绘制, 渐变使用按字符定位的条带着色器, 条带过大时逐字符绘制渐变
+    //        阴影滤镜作用于整个图层(忽略 shadow_mode), 相邻字符的不同图层之间按图层顺序叠加
+    std::string render_engine;
+    // 阴影绘制方式
+    // mask   每个字符只光栅化一次覆盖率蒙版, 阴影由蒙版模糊、偏移、着色得到, 相同模糊半径只模糊一次
+    // filter 每个阴影图层使用 DropShadow 滤镜重新绘制文字
+    // page   (canvas 方式)每个阴影图层的所有字符绘制到同一个 saveLayer, 滤镜在整个页面上只执行一次
+    //        图层按顺序逐层绘制, 阴影超出字符区域的部分由字符间距及 glyph_padding 隔离
+    std::string shadow_mode;
+    // mask 方式的模糊实现
+    // skia 使用 SkImageFilters::Blur
+    // box  单通道蒙版上三次盒式模糊近似高斯模糊(滑动窗口, 水平垂直分离), 结果与 skia 略有差异
+    //      盒式模糊无法准确近似的较小模糊半径(约3以下)仍使用 skia
+    std::string blur_engine;
+    // box 模糊半径较大时在 1/2 或 1/4 分辨率下模糊再放大, 允许的最大误差(0~255 灰度级, <=0 不降采样)
+    // 按模糊后边缘的插值误差估计选择最小的分辨率, 例如 1.0 时 blur_radius 约 6 以上使用 1/2, 约 11 以上使用 1/4
+    float blur_max_error;
+    // 描边生成方式
+    // stroke 描边字符轮廓(SkStrokeRec)
+    // edt    对放大光栅化的字符填充做精确欧氏距离变换, 距离轮廓 outline_thickness * outline_thickness_render_scale / 2 以内的部分为描边
+    //        耗时与轮廓复杂度及描边宽度无关, 没有拐角连接瑕疵; render_engine 为 blob 时仍使用 stroke
+    std::string outline_engine;
+    // 输出内容
+    // bitmap 按文字样式绘制的位图
+    // sdf    单通道有符号距离场(alpha通道), 忽略描边、阴影、特效, 由运行时着色器绘制任意大小、描边、外发光
+    // msdf   多通道有符号距离场(RGB通道), 由字符轮廓计算, 放大后仍保留尖锐拐角
+    std::string render_mode;
+    // 距离场范围(像素), 字符四周额外预留该距离, 轮廓内外 sdf_spread 像素映射到 0~255
+    int sdf_spread;
+    // sdf距离场计算分辨率(倍数), 字符以该倍数放大光栅化后计算距离, 再缩小到输出大小
+    int sdf_scale;
+    // 页面图片格式
+    // rgba RGBA彩色图片
+    // a8   单通道灰度图片(字符透明度), 颜色由运行时着色, 适用于单色样式
+    //      保存为不透明灰度png, fnt中 alphaChnl=4, RGB 为字符, 运行时需以亮度作为透明度
+    // auto 样式为单色时(无渐变, 文字、描边、阴影颜色相同, 默认混合模式)使用a8, 否则使用rgba
+    // layers 分层通道, R 文字填充覆盖率, G 描边覆盖率, B 阴影/外发光覆盖率, A 三者的最大值
+    //        忽略颜色、渐变及混合模式, 由运行时着色器分别着色, 同一图集可用于任意配色
+    std::string output_format;
+    // 通道打包(仅单色样式), 每4个页面分别写入同一张纹理的R、G、B、A通道, fnt中 packed=1 并为每个字符设置 chnl
+    // 只有一个页面时先按占用面积均分为4个页面
+    bool channel_packing;
     // 输出文件
     std::string output_file;
     // 字距
@@ -240,11 +391,37 @@ struct GenerateConfig
     bool is_fully_wrapped_mode;
     // 输出图片最大宽度
     int max_width;
-
+    // 输出图片最大高度(<=0不限制), 超出时自动拆分为多个页面
+    int max_height;
+    // 页面拆分方式
+    // fill     依次填满每个页面, 最后一个页面可能很空
+    // balanced 页面数量不变, 同一页面拆分出的各页面字符占用面积大致相同, 且宽高一致(可用于纹理数组)
+    //          未拆分的页面保持原有宽高
+    std::string page_split_mode;
+    // 多个页面包含相同字符时字符的归属规则
+    // first_page 第一个包含该字符的页面渲染
+    // priority   优先级(PageConfig::priority)最高的页面渲染, 优先级相同时取靠前的页面
+    // none       不去重, 每个页面都渲染(fnt中会出现重复的char id)
+    // first_page 及 priority 只在字体包含该字符的页面中选择, 所有页面字体都不包含时才使用系统字体回退
+    std::string codepoint_owner;
+
+    // 字符使用频率文件, 设置后按使用频率从高到低重新分配页面(常用字符集中在第0页)
+    std::string frequency_file;
+    // 字符使用频率文件格式
+    // counts 每行一个字符及其次数, 如 "的 12345" 或 "U+7684 12345"
+    // corpus 语料/运行时日志文本, 统计文件中每个字符出现的次数
+    std::string frequency_format;
 
     // 字体样式
     TextStyle text_style;
 
+    // 自动适配字体大小
+    FitTo fit_to;
+    // 自动适配时的页面宽高限制, 由 fitFontSize 设置, 不写入配置文件
+    // 不会超过 max_width/max_height, <=0 时只使用 max_width/max_height, 见 pageMaxWidth/pageMaxHeight
+    int fitted_width;
+    int fitted_height;
+
     std::vector<PageConfig> pages;
 
 
@@ -262,6 +439,18 @@ struct GenerateConfig
 };
 AJSON(GenerateConfig,
     use_gpu,
+    render_threads,
+    render_memory_budget,
+    render_engine,
+    shadow_mode,
+    blur_engine,
+    blur_max_error,
+    outline_engine,
+    render_mode,
+    sdf_spread,
+    sdf_scale,
+    output_format,
+    channel_packing,
     output_file,
     spacing_horiz,
     spacing_vert,
@@ -281,8 +470,14 @@ AJSON(GenerateConfig,
     is_NPOT,
     is_fully_wrapped_mode,
     max_width,
+    max_height,
+    page_split_mode,
+    codepoint_owner,
+    frequency_file,
+    frequency_format,
     is_draw_debug,
     text_style,
+    fit_to,
     pages
 )
 
@@ -290,9 +485,16 @@ struct GlyphInfo
 {
     char32_t codepoint;
     SkFont font;
+    SkGlyphID glyph_id;
 
     int x;
     int y;
+    // 绘制字符时的基线位置
+    SkScalar draw_x;
+    SkScalar draw_y;
+    // 字符原始宽高(不含描边和间距)
+    int raw_width;
+    int raw_height;
     // 字符实际占用宽度
     int width;
     // 字符实际占用高度
@@ -321,11 +523,17 @@ struct GlyphInfo
 struct FntPage
 {
     // 是否固定宽度对齐(按最大字符宽度)
-    bool fixed_width_alignment;
-    int width;
-    int height;
+    bool fixed_width_alignment = false;
+    int width = 0;
+    int height = 0;
     std::vector<GlyphInfo> glyphs;
     std::string fileName;
+    // 通道打包时所在的纹理编号
+    int texture = 0;
+    // 通道打包时所在的通道(1 R, 2 G, 3 B, 4 A), 0 不打包
+    int packed_channel = 0;
+    // 按最大高度拆分出的页面为拆分前的页面编号, 均分模式下编号相同的页面宽高一致; -1 未拆分
+    int split_source = -1;
 };
 
 struct FntInfo
@@ -351,3 +559,37 @@ struct FntInfo
     std::vector<FntPage> pages;
 };
 
+// 各纹理格式的显存估算(字节)
+struct PlanMemory
+{
+    int64_t rgba8888;
+    int64_t rgba4444;
+    int64_t a8;
+    int64_t etc2_rgba8;
+    int64_t astc_4x4;
+};
+AJSON(PlanMemory, rgba8888, rgba4444, a8, etc2_rgba8, astc_4x4);
+
+// 单张纹理(通道打包时包含多个页面)
+struct PlanPage
+{
+    std::string file;
+    int width;
+    int height;
+    int glyph_count;
+    // 字符占用面积 / 页面面积(通道打包时为各通道面积之和)
+    float fill_ratio;
+    PlanMemory memory;
+};
+AJSON(PlanPage, file, width, height, glyph_count, fill_ratio, memory);
+
+// --plan 输出结果
+struct PlanReport
+{
+    std::vector<PlanPage> pages;
+    int glyph_count;
+    PlanMemory memory;
+    // 没有找到匹配字体的字符
+    std::vector<uint32_t> missing_chars;
+};
+AJSON(PlanReport, pages, glyph_count, memory, missing_chars);
@@ -0,0 +1,501 @@
+﻿#include "DistanceField.h"
+#include "async++.h"
+
+// 一维距离平方变换, 计算下包络抛物线
+// f: 输入, d: 输出, v: 抛物线顶点位置, z: 抛物线交点
+static void distanceTransform1D(const float* f, float* d, int n, int* v, float* z)
+{
+    int k = 0;
+    v[0] = 0;
+    z[0] = -DISTANCE_INF;
+    z[1] = DISTANCE_INF;
+    for (int q = 1; q < n; ++q)
+    {
+        float s = ((f[q] + (float)q * q) - (f[v[k]] + (float)v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+        while (s <= z[k])
+        {
+            --k;
+            s = ((f[q] + (float)q * q) - (f[v[k]] + (float)v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = DISTANCE_INF;
+    }
+
+    k = 0;
+    for (int q = 0; q < n; ++q)
+    {
+        while (z[k + 1] < q)
+            ++k;
+        float dx = (float)(q - v[k]);
+        d[q] = dx * dx + f[v[k]];
+    }
+}
+
+void distanceTransform(std::vector<float>& grid, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    // 按列
+    async::parallel_for(async::irange(0, width), [&](int x) {
+        std::vector<float> f(height), d(height), z(height + 1);
+        std::vector<int> v(height);
+        for (int y = 0; y < height; ++y)
+            f[y] = grid[(size_t)y * width + x];
+        distanceTransform1D(f.data(), d.data(), height, v.data(), z.data());
+        for (int y = 0; y < height; ++y)
+            grid[(size_t)y * width + x] = d[y];
+    });
+
+    // 按行
+    async::parallel_for(async::irange(0, height), [&](int y) {
+        std::vector<float> d(width), z(width + 1);
+        std::vector<int> v(width);
+        float* row = &grid[(size_t)y * width];
+        distanceTransform1D(row, d.data(), width, v.data(), z.data());
+        std::copy(d.begin(), d.end(), row);
+    });
+}
+
+std::vector<float> signedDistanceField(const SkPixmap& coverage)
+{
+    int width = coverage.width();
+    int height = coverage.height();
+    size_t count = (size_t)width * height;
+
+    // 到最近内部像素的距离, 到最近外部像素的距离
+    std::vector<float> toInside(count), toOutside(count);
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* row = coverage.addr8(0, y);
+        for (int x = 0; x < width; ++x)
+        {
+            size_t index = (size_t)y * width + x;
+            bool inside = row[x] >= 128;
+            toInside[index] = inside ? 0.0f : DISTANCE_INF;
+            toOutside[index] = inside ? DISTANCE_INF : 0.0f;
+        }
+    }
+
+    distanceTransform(toInside, width, height);
+    distanceTransform(toOutside, width, height);
+
+    // 轮廓位于相邻内外像素中心之间, 距离减去半个像素
+    std::vector<float> field(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (toInside[i] == 0.0f)
+            field[i] = std::sqrt(toOutside[i]) - 0.5f;
+        else
+            field[i] = 0.5f - std::sqrt(toInside[i]);
+    }
+    return field;
+}
+
+// 边的颜色, 按位表示包含的通道
+enum EdgeColor
+{
+    EDGE_RED = 1,
+    EDGE_GREEN = 2,
+    EDGE_BLUE = 4,
+    EDGE_YELLOW = EDGE_RED | EDGE_GREEN,
+    EDGE_MAGENTA = EDGE_RED | EDGE_BLUE,
+    EDGE_CYAN = EDGE_GREEN | EDGE_BLUE,
+    EDGE_WHITE = EDGE_RED | EDGE_GREEN | EDGE_BLUE,
+};
+
+// 轮廓边, 曲线细分为折线
+struct ContourEdge
+{
+    std::vector<SkPoint> points;
+    // 起点及终点的切线方向
+    SkVector startDir;
+    SkVector endDir;
+    int color;
+};
+
+typedef std::vector<ContourEdge> Contour;
+
+// 到边的有符号距离, 距离相同时 dot 越小(越垂直)越近
+struct EdgeDistance
+{
+    float distance;
+    float dot;
+    // 最近点所在线段及其参数
+    int segment;
+    float t;
+};
+
+static bool isCloser(const EdgeDistance& a, const EdgeDistance& b)
+{
+    float da = std::abs(a.distance);
+    float db = std::abs(b.distance);
+    return da < db || (da == db && a.dot < b.dot);
+}
+
+static SkPoint evalCurve(const SkPoint* pts, int count, SkScalar weight, float t)
+{
+    float mt = 1.0f - t;
+    if (count == 3)
+    {
+        // 二次曲线及圆锥曲线
+        float w0 = mt * mt, w1 = 2.0f * weight * t * mt, w2 = t * t;
+        float sum = w0 + w1 + w2;
+        return SkPoint::Make((pts[0].x() * w0 + pts[1].x() * w1 + pts[2].x() * w2) / sum, (pts[0].y() * w0 + pts[1].y() * w1 + pts[2].y() * w2) / sum);
+    }
+    float w0 = mt * mt * mt, w1 = 3.0f * t * mt * mt, w2 = 3.0f * t * t * mt, w3 = t * t * t;
+    return SkPoint::Make(pts[0].x() * w0 + pts[1].x() * w1 + pts[2].x() * w2 + pts[3].x() * w3, pts[0].y() * w0 + pts[1].y() * w1 + pts[2].y() * w2 + pts[3].y() * w3);
+}
+
+static void addEdge(Contour& contour, const SkPoint* pts, int count, SkScalar weight)
+{
+    // 忽略退化的边
+    bool degenerate = true;
+    for (int i = 1; i < count; ++i)
+        degenerate &= pts[i] == pts[0];
+    if (degenerate)
+        return;
+
+    ContourEdge edge;
+    edge.color = EDGE_WHITE;
+
+    // 切线方向取第一个(最后一个)不重合的控制点
+    for (int i = 1; i < count; ++i)
+    {
+        if (pts[i] != pts[0])
+        {
+            edge.startDir = pts[i] - pts[0];
+            break;
+        }
+    }
+    for (int i = count - 2; i >= 0; --i)
+    {
+        if (pts[i] != pts[count - 1])
+        {
+            edge.endDir = pts[count - 1] - pts[i];
+            break;
+        }
+    }
+    edge.startDir.normalize();
+    edge.endDir.normalize();
+
+    edge.points.push_back(pts[0]);
+    if (count > 2)
+    {
+        // 按控制多边形长度细分, 约每像素一段
+        float length = 0.0f;
+        for (int i = 1; i < count; ++i)
+            length += SkPoint::Distance(pts[i - 1], pts[i]);
+        int steps = std::min(std::max((int)std::ceil(length), 2), 64);
+        for (int i = 1; i < steps; ++i)
+            edge.points.push_back(evalCurve(pts, count, weight, (float)i / steps));
+    }
+    edge.points.push_back(pts[count - 1]);
+    contour.push_back(std::move(edge));
+}
+
+static std::vector<Contour> buildContours(const SkPath& path)
+{
+    std::vector<Contour> contours;
+    SkPath::Iter iter(path, true);
+    SkPoint pts[4];
+    SkPath::Verb verb;
+    while ((verb = iter.next(pts)) != SkPath::kDone_Verb)
+    {
+        switch (verb)
+        {
+        case SkPath::kMove_Verb:
+            contours.emplace_back();
+            break;
+        case SkPath::kLine_Verb:
+            if (!contours.empty())
+                addEdge(contours.back(), pts, 2, 1.0f);
+            break;
+        case SkPath::kQuad_Verb:
+            if (!contours.empty())
+                addEdge(contours.back(), pts, 3, 1.0f);
+            break;
+        case SkPath::kConic_Verb:
+            if (!contours.empty())
+                addEdge(contours.back(), pts, 3, iter.conicWeight());
+            break;
+        case SkPath::kCubic_Verb:
+            if (!contours.empty())
+                addEdge(contours.back(), pts, 4, 1.0f);
+            break;
+        default:
+            break;
+        }
+    }
+
+    contours.erase(std::remove_if(contours.begin(), contours.end(), [](const Contour& contour) { return contour.empty(); }), contours.end());
+    return contours;
+}
+
+// 将边拆分为 parts 段, 折线点数不足时线性插值
+static std::vector<ContourEdge> splitEdge(const ContourEdge& edge, int parts)
+{
+    std::vector<SkPoint> points = edge.points;
+    while ((int)points.size() - 1 < parts)
+    {
+        std::vector<SkPoint> refined;
+        for (size_t i = 0; i + 1 < points.size(); ++i)
+        {
+            refined.push_back(points[i]);
+            refined.push_back(SkPoint::Make((points[i].x() + points[i + 1].x()) * 0.5f, (points[i].y() + points[i + 1].y()) * 0.5f));
+        }
+        refined.push_back(points.back());
+        points = std::move(refined);
+    }
+
+    std::vector<ContourEdge> result;
+    int segments = (int)points.size() - 1;
+    for (int i = 0; i < parts; ++i)
+    {
+        int first = segments * i / parts;
+        int last = segments * (i + 1) / parts;
+
+        ContourEdge part;
+        part.color = edge.color;
+        part.points.assign(points.begin() + first, points.begin() + last + 1);
+        part.startDir = i == 0 ? edge.startDir : part.points[1] - part.points[0];
+        part.endDir = i == parts - 1 ? edge.endDir : part.points[part.points.size() - 1] - part.points[part.points.size() - 2];
+        part.startDir.normalize();
+        part.endDir.normalize();
+        result.push_back(std::move(part));
+    }
+    return result;
+}
+
+// 按拐角为轮廓边着色, 拐角两侧的边颜色不同且共享一个通道
+static void colorEdges(Contour& contour)
+{
+    // 夹角超过约3弧度的补角(sin(3))视为拐角
+    const float crossThreshold = std::sin(3.0f);
+
+    std::vector<size_t> corners;
+    for (size_t i = 0; i < contour.size(); ++i)
+    {
+        const SkVector& a = contour[(i + contour.size() - 1) % contour.size()].endDir;
+        const SkVector& b = contour[i].startDir;
+        if (SkPoint::DotProduct(a, b) <= 0.0f || std::abs(SkPoint::CrossProduct(a, b)) > crossThreshold)
+            corners.push_back(i);
+    }
+
+    // 平滑轮廓
+    if (corners.empty())
+    {
+        for (auto& edge : contour)
+            edge.color = EDGE_WHITE;
+        return;
+    }
+
+    // 只有一个拐角(水滴形), 拆分为三段分别着色
+    if (corners.size() == 1)
+    {
+        const int colors[3] = { EDGE_MAGENTA, EDGE_WHITE, EDGE_YELLOW };
+
+        // 从拐角开始排列
+        Contour edges;
+        for (size_t i = 0; i < contour.size(); ++i)
+            edges.push_back(contour[(corners[0] + i) % contour.size()]);
+
+        if (edges.size() < 3)
+        {
+            Contour parts;
+            for (auto& edge : edges)
+            {
+                auto split = splitEdge(edge, edges.size() == 1 ? 3 : 2);
+                parts.insert(parts.end(), split.begin(), split.end());
+            }
+            edges = std::move(parts);
+        }
+
+        for (size_t i = 0; i < edges.size(); ++i)
+            edges[i].color = colors[std::min(i * 3 / edges.size(), (size_t)2)];
+        contour = std::move(edges);
+        return;
+    }
+
+    // 多个拐角, 拐角之间的边依次使用 CYAN, MAGENTA, YELLOW
+    const int colors[3] = { EDGE_CYAN, EDGE_MAGENTA, EDGE_YELLOW };
+    size_t splineCount = corners.size();
+    size_t spline = 0;
+    for (size_t i = 0; i < contour.size(); ++i)
+    {
+        size_t index = (corners[0] + i) % contour.size();
+        if (spline + 1 < splineCount && index == corners[spline + 1])
+            ++spline;
+
+        int color = colors[spline % 3];
+        // 最后一段与第一段相邻, 不能同色
+        if (spline == splineCount - 1 && spline % 3 == 0)
+            color = EDGE_MAGENTA;
+        contour[index].color = color;
+    }
+}
+
+// 点到边的有符号距离, 正负由边的方向决定(右侧为正)
+static EdgeDistance edgeDistance(const ContourEdge& edge, const SkPoint& p)
+{
+    EdgeDistance best{ DISTANCE_INF, 1.0f, 0, 0.0f };
+    for (size_t i = 0; i + 1 < edge.points.size(); ++i)
+    {
+        const SkPoint& a = edge.points[i];
+        SkVector ab = edge.points[i + 1] - a;
+        float lengthSqd = SkPoint::DotProduct(ab, ab);
+        if (lengthSqd <= 0.0f)
+            continue;
+
+        float t = SkPoint::DotProduct(p - a, ab) / lengthSqd;
+        float tc = std::min(std::max(t, 0.0f), 1.0f);
+        SkVector pq = p - (a + ab * tc);
+        float distance = pq.length();
+        float dot = distance > 0.0f ? std::abs(SkPoint::DotProduct(ab, pq)) / (std::sqrt(lengthSqd) * distance) : 0.0f;
+
+        EdgeDistance candidate{ SkPoint::CrossProduct(ab, p - a) >= 0.0f ? distance : -distance, dot, (int)i, t };
+        if (isCloser(candidate, best))
+            best = candidate;
+    }
+    return best;
+}
+
+// 最近点在边的端点之外时, 改为到端点切线延长线的距离
+static float pseudoDistance(const ContourEdge& edge, const EdgeDistance& distance, const SkPoint& p)
+{
+    int lastSegment = (int)edge.points.size() - 2;
+    if (distance.segment == 0 && distance.t < 0.0f)
+    {
+        float pseudo = SkPoint::CrossProduct(edge.startDir, p - edge.points.front());
+        if (std::abs(pseudo) <= std::abs(distance.distance))
+            return pseudo;
+    }
+    else if (distance.segment == lastSegment && distance.t > 1.0f)
+    {
+        float pseudo = SkPoint::CrossProduct(edge.endDir, p - edge.points.back());
+        if (std::abs(pseudo) <= std::abs(distance.distance))
+            return pseudo;
+    }
+    return distance.distance;
+}
+
+std::vector<float> multiChannelDistanceField(const SkPath& path, int width, int height)
+{
+    std::vector<float> field((size_t)width * height * 3, -DISTANCE_INF);
+
+    std::vector<Contour> contours = buildContours(path);
+    if (contours.empty())
+        return field;
+
+    // 轮廓方向: 外轮廓面积占优, 面积为负时翻转符号使内部为正
+    float area = 0.0f;
+    for (auto& contour : contours)
+    {
+        colorEdges(contour);
+        for (auto& edge : contour)
+        {
+            for (size_t i = 0; i + 1 < edge.points.size(); ++i)
+                area += SkPoint::CrossProduct(edge.points[i], edge.points[i + 1]);
+        }
+    }
+    float orientation = area >= 0.0f ? 1.0f : -1.0f;
+
+    async::parallel_for(async::irange(0, height), [&](int y) {
+        for (int x = 0; x < width; ++x)
+        {
+            SkPoint p = SkPoint::Make(x + 0.5f, y + 0.5f);
+
+            // 每个通道最近的边
+            const ContourEdge* nearestEdges[3] = { nullptr, nullptr, nullptr };
+            EdgeDistance nearest[3];
+            for (auto& contour : contours)
+            {
+                for (auto& edge : contour)
+                {
+                    EdgeDistance distance = edgeDistance(edge, p);
+                    for (int channel = 0; channel < 3; ++channel)
+                    {
+                        if ((edge.color & (1 << channel)) && (!nearestEdges[channel] || isCloser(distance, nearest[channel])))
+                        {
+                            nearestEdges[channel] = &edge;
+                            nearest[channel] = distance;
+                        }
+                    }
+                }
+            }
+
+            float* dst = &field[((size_t)y * width + x) * 3];
+            for (int channel = 0; channel < 3; ++channel)
+            {
+                if (nearestEdges[channel])
+                    dst[channel] = orientation * pseudoDistance(*nearestEdges[channel], nearest[channel], p);
+            }
+        }
+    });
+    return field;
+}
+
+static float median(float a, float b, float c)
+{
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+// 相邻像素 a, b 之间是否存在两个通道同时跳变, 只标记离轮廓较远的像素
+static bool detectClash(const float* a, const float* b, float threshold)
+{
+    float a0 = a[0], a1 = a[1], a2 = a[2];
+    float b0 = b[0], b1 = b[1], b2 = b[2];
+
+    // 按差值从大到小排列通道
+    if (std::abs(b0 - a0) < std::abs(b1 - a1))
+    {
+        std::swap(a0, a1);
+        std::swap(b0, b1);
+    }
+    if (std::abs(b1 - a1) < std::abs(b2 - a2))
+    {
+        std::swap(a1, a2);
+        std::swap(b1, b2);
+        if (std::abs(b0 - a0) < std::abs(b1 - a1))
+        {
+            std::swap(a0, a1);
+            std::swap(b0, b1);
+        }
+    }
+    return std::abs(b1 - a1) >= threshold
+        && !(b0 == b1 && b0 == b2)
+        && std::abs(a2) >= std::abs(b2);
+}
+
+void correctDistanceFieldErrors(std::vector<float>& field, int width, int height)
+{
+    // 相邻像素的真实距离最多相差1像素, 超过的跳变由通道间插值产生
+    const float threshold = 1.001f;
+
+    std::vector<char> clashes((size_t)width * height, 0);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const float* texel = &field[((size_t)y * width + x) * 3];
+            if ((x > 0 && detectClash(texel, texel - 3, threshold))
+                || (x < width - 1 && detectClash(texel, texel + 3, threshold))
+                || (y > 0 && detectClash(texel, texel - (size_t)width * 3, threshold))
+                || (y < height - 1 && detectClash(texel, texel + (size_t)width * 3, threshold)))
+            {
+                clashes[(size_t)y * width + x] = 1;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < clashes.size(); ++i)
+    {
+        if (!clashes[i])
+            continue;
+        float* texel = &field[i * 3];
+        float value = median(texel[0], texel[1], texel[2]);
+        texel[0] = texel[1] = texel[2] = value;
+    }
+}
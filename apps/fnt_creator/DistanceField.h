@@ -0,0 +1,33 @@
+﻿#pragma once
+
+#include "Common.h"
+#include <include/core/SkPath.h>
+
+// 距离变换中表示无穷远
+const float DISTANCE_INF = 1e20f;
+
+// 二维精确欧氏距离平方变换(Felzenszwalb & Huttenlocher)
+// grid 中特征像素为0, 其余为 DISTANCE_INF, 变换后为每个像素到最近特征像素的距离平方
+// 先按列再按行做一维变换, 各列(行)之间并行计算
+void distanceTransform(std::vector<float>& grid, int width, int height);
+
+// 由覆盖率蒙版(kAlpha_8)生成有符号距离场
+// 覆盖率以0.5为阈值区分内外, 返回每个像素中心到轮廓的距离(像素), 内部为正
+std::vector<float> signedDistanceField(const SkPixmap& coverage);
+
+// 由字符轮廓生成多通道有符号距离场(MSDF)
+// path 为字符轮廓在距离场像素坐标中的位置, 像素(x, y)的采样点为(x + 0.5, y + 0.5)
+// 轮廓边按拐角着色后, 每个通道分别计算到对应颜色的边的伪距离, 放大后通过三个通道的中值还原尖锐拐角
+// 返回 width * height * 3 个距离(像素, 内部为正), 按RGB顺序排列
+std::vector<float> multiChannelDistanceField(const SkPath& path, int width, int height);
+
+// 修正MSDF中相邻像素通道插值产生的错误(两个通道同时跳变), 被标记的像素三个通道取中值
+// field 为 multiChannelDistanceField 的结果
+void correctDistanceFieldErrors(std::vector<float>& field, int width, int height);
+
+// 将距离映射为0~255, 轮廓处为128, 距离超过 spread 的部分截断
+inline uint8_t encodeDistance(float distance, float spread)
+{
+	float value = (distance / spread * 0.5f + 0.5f) * 255.0f + 0.5f;
+	return (uint8_t)std::min(std::max(value, 0.0f), 255.0f);
+}
@@ -272,7 +272,8 @@ void Editor::fntRender()
 
     m_needReRender = false;
 
-    if (m_gen->supportGPU() && m_config.use_gpu)
+    // 按解析后的配置判断, 编辑器中会关闭通道打包等只在CPU上执行的选项
+    if (m_gen->isGPURendering(m_config))
     {
         if (m_gen->run(m_config))
         {
@@ -381,6 +382,15 @@ void Editor::imguiDraw()
 
         refresh |= ImGui::Checkbox("use_gpu", &m_config.use_gpu);
 
+        const char* arrRenderMode[] = { "bitmap", "sdf", "msdf" };
+        refresh |= imguiOption("render_mode", &m_config.render_mode, arrRenderMode, IM_ARRAYSIZE(arrRenderMode));
+        if (isDistanceFieldMode(m_config))
+        {
+            refresh |= ImGui::SliderInt("sdf_spread", &m_config.sdf_spread, 1, 32);
+            if (m_config.render_mode == "sdf")
+                refresh |= ImGui::SliderInt("sdf_scale", &m_config.sdf_scale, 1, 8);
+        }
+
         char szbuf[2048] = { 0 };
         strcpy_s(szbuf, m_config.output_file.c_str());
         if (ImGui::InputText("output_file", szbuf, sizeof(szbuf)))
@@ -455,11 +465,14 @@ void Editor::imguiDraw()
         refresh |= imguiColor("color", &style.color);
         refresh |= imguiTextEffect("effect", style.effect);
         refresh |= imguiTextShadows("shadows", style.shadows);
+        refresh |= imguiMaskEffects("mask_effects", style.mask_effects);
         ImGui::Separator();
 
         refresh |= ImGui::SliderInt("outline_thickness", &style.outline_thickness, 0, 20);
         refresh |= ImGui::SliderFloat("outline_thickness_render_scale", &style.outline_thickness_render_scale, 0.5, 3.0f);
         refresh |= imguiColor("outline_color", &style.outline_color);
+        const char* arrOutlinePosition[] = { "center", "inside", "outside" };
+        refresh |= imguiOption("outline_position", &style.outline_position, arrOutlinePosition, IM_ARRAYSIZE(arrOutlinePosition));
         refresh |= imguiBlendMode("outline_blend_mode", &style.outline_blend_mode);
         refresh |= imguiTextEffect("outline_effect", style.outline_effect);
         refresh |= imguiTextShadows("outline_shadows", style.outline_shadows);
@@ -490,6 +503,26 @@ bool Editor::imguiColor(const char* label, std::string* color)
     return false;
 }
 
+bool Editor::imguiOption(const char* label, std::string* value, const char* const* options, int count)
+{
+    int index = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (*value == options[i])
+        {
+            index = i;
+            break;
+        }
+    }
+
+    if (ImGui::Combo(label, &index, options, count))
+    {
+        *value = options[index];
+        return true;
+    }
+    return false;
+}
+
 bool Editor::imguiBlendMode(const char* label, std::string* model)
 {
     const char* arrBlendMode[] = { "Clear", "Src", "Dst", "SrcOver", "DstOver", "SrcIn", "DstIn", "SrcOut", "DstOut", "SrcATop", "DstATop", "Xor", "Plus", "Modulate", "Screen", "Overlay", "Darken", "Lighten", "ColorDodge", "ColorBurn", "HardLight", "SoftLight", "Difference", "Exclusion", "Multiply", "Hue", "Saturation", "Color", "Luminosity", "LastCoeffMode", "LastSeparableMode", "LastMode", "Default"};
@@ -659,4 +692,71 @@ bool Editor::imguiTextShadows(const char* label, std::vector<TextShadow>& shadow
     }
     ImGui::PopID();
     return refresh;
-}
\ No newline at end of file
+}
+
+bool Editor::imguiMaskEffects(const char* label, std::vector<MaskEffect>& effects)
+{
+    bool refresh = false;
+    ImGui::PushID(label);
+
+    if (ImGui::Button("add mask effect"))
+    {
+        effects.push_back(MaskEffect());
+        refresh = true;
+    }
+
+    if (ImGui::BeginTabBar(label))
+    {
+        const char* arrEffectType[] = { "inner_shadow", "inner_glow", "bevel" };
+
+        int remove_index = -1;
+        size_t index = 0;
+        for (auto& effect : effects)
+        {
+            index++;
+            auto name = stringFormat("effect_%d", (int)index);
+            if (ImGui::BeginTabItem(name.c_str()))
+            {
+                ImGui::PushID(index);
+                ImGui::Text(name.c_str());
+                ImGui::SameLine();
+                if (ImGui::Button("remove"))
+                {
+                    remove_index = int(index - 1);
+                }
+
+                refresh |= imguiOption("effect_type", &effect.effect_type, arrEffectType, IM_ARRAYSIZE(arrEffectType));
+                if (effect.effect_type == "bevel")
+                {
+                    refresh |= ImGui::DragFloat("size", &effect.size, 0.1f, 1.0f, 100.0f);
+                    refresh |= ImGui::SliderFloat("angle", &effect.angle, 0.0f, 360.0f);
+                    refresh |= imguiColor("highlight_color", &effect.highlight_color);
+                    refresh |= imguiColor("shadow_color", &effect.shadow_color);
+                }
+                else
+                {
+                    if (effect.effect_type == "inner_shadow")
+                    {
+                        refresh |= ImGui::DragInt("offsetx", &effect.offsetx);
+                        refresh |= ImGui::DragInt("offsety", &effect.offsety);
+                    }
+                    refresh |= ImGui::DragFloat("blur_radius", &effect.blur_radius);
+                    refresh |= imguiColor("color", &effect.color);
+                }
+
+                ImGui::PopID();
+                ImGui::EndTabItem();
+            }
+        }
+
+        if (remove_index != -1)
+        {
+            effects.erase(effects.begin() + remove_index);
+            refresh = true;
+        }
+
+        ImGui::EndTabBar();
+    }
+    ImGui::PopID();
+    return refresh;
+}
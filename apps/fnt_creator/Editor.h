@@ -28,12 +28,16 @@ private:
 
 	bool imguiColor(const char* label, std::string* color);
 
+	bool imguiOption(const char* label, std::string* value, const char* const* options, int count);
+
 	bool imguiBlendMode(const char* label, std::string* model);
 
 	bool imguiTextEffect(const char* label, TextEffect& effect);
 
 	bool imguiTextShadows(const char* label, std::vector<TextShadow>& shadows);
 
+	bool imguiMaskEffects(const char* label, std::vector<MaskEffect>& effects);
+
 private:
 
 	bool m_needReRender;
@@ -1,6 +1,8 @@
 ﻿#include "FntGen.h"
 #include "Utils.h"
 #include "Clock.h"
+#include "GlyphMask.h"
+#include "DistanceField.h"
 
 #define NOMINMAX
 
@@ -8,6 +10,10 @@
 #define SK_GL
 #include "include/core/SkSurface.h"
 #include "include/core/Skcanvas.h"
+#include "include/core/SkTextBlob.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkBlender.h"
 #include "include/gpu/GrDirectContext.h"
 #include "include/gpu/gl/GrGLInterface.h"
 #include "include/gpu/GrBackendSurface.h"
@@ -17,19 +23,94 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <assert.h>
+#include "async++.h"
 
 // is_fully_wrapped_mode == false时
 // 开启之后 底部基准线以实际文字对齐，关闭则以文字描边对齐
 #define BASE_IN_REAL_TEXT_BOTTOM 1
 
 FntGen::FntGen()
-    : m_maxOffsetY(0)
-    , m_isEditorMode(false)
+    : m_isEditorMode(false)
     , m_editorShowPageIndex(0)
+    , m_maxOffsetY(0)
+    , m_gpuInitialized(false)
+    , m_window(nullptr)
+    , m_ownerThread(std::this_thread::get_id())
 {
     m_pageRenderOpenglData.texture_id = 0;
     m_pageRenderOpenglData.width = 0;
     m_pageRenderOpenglData.height = 0;
+}
+
+FntGen::~FntGen()
+{
+    // 先释放skia上下文, 再销毁其使用的opengl上下文
+    m_context = nullptr;
+    if (m_window)
+    {
+        glfwDestroyWindow(m_window);
+        glfwTerminate();
+        m_window = nullptr;
+    }
+}
+
+bool FntGen::isGPURendering(const GenerateConfig& config)
+{
+    return useGPURendering(resolveRenderConfig(config));
+}
+
+bool FntGen::useGPURendering(const GenerateConfig& config)
+{
+    // 距离场、通道打包及分层通道只在CPU上计算(编辑器预览分层通道时使用彩色)
+    if (!config.use_gpu || isDistanceFieldMode(config) || config.channel_packing)
+        return false;
+    if (config.output_format == "layers" && !m_isEditorMode)
+        return false;
+    return supportGPU();
+}
+
+bool FntGen::supportGPU()
+{
+    assert(std::this_thread::get_id() == m_ownerThread && "GPU rendering must run on the thread that owns the opengl context");
+    if (!m_gpuInitialized)
+    {
+        m_gpuInitialized = true;
+        initGPU();
+    }
+    return m_context != nullptr;
+}
+
+void FntGen::initGPU()
+{
+    // glfw 及opengl上下文只能在所属线程中初始化
+    assert(std::this_thread::get_id() == m_ownerThread && "initGPU must run on the thread that owns the opengl context");
+
+    // 编辑器已创建opengl上下文, 命令行模式在首次使用GPU渲染时才创建隐藏窗口
+    // 没有显示设备时初始化失败, 使用CPU渲染
+    if (glfwInit() != GLFW_TRUE)
+    {
+        std::cerr << "Failed to initialize GLFW, using CPU rendering" << std::endl;
+        return;
+    }
+
+    if (glfwGetCurrentContext() == nullptr)
+    {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        m_window = glfwCreateWindow(1, 1, "", nullptr, nullptr);
+        if (m_window == nullptr)
+        {
+            std::cerr << "Failed to create opengl context, using CPU rendering" << std::endl;
+            glfwTerminate();
+            return;
+        }
+        glfwMakeContextCurrent(m_window);
+
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+        {
+            std::cerr << "Failed to initialize GLAD" << std::endl;
+            return;
+        }
+    }
 
     auto interface = GrGLMakeNativeInterface();
     if (!interface) 
@@ -43,33 +124,110 @@ FntGen::FntGen()
         m_context = nullptr;
 }
 
-FntGen::~FntGen()
+bool FntGen::run(const GenerateConfig& config)
 {
+    return generate(resolveRenderConfig(config));
 }
 
-bool FntGen::run(const GenerateConfig& config)
+bool FntGen::plan(const GenerateConfig& config, const std::string& reportFile)
 {
-    m_outFileName = config.output_file;
-    if (m_outFileName.size() > 4 && _stricmp(m_outFileName.substr(m_outFileName.length() - 4).c_str(), ".fnt") == 0)
-        m_outFileName = m_outFileName.substr(0, m_outFileName.length() - 4);
+    return planLayout(resolveRenderConfig(config), reportFile);
+}
 
-    m_fntInfo.fontSize = config.text_style.font_size;
-    m_fntInfo.isBold = config.text_style.is_bold;
-    m_fntInfo.isItalic = config.text_style.is_italic;
-    m_fntInfo.useUnicode = true;
-    m_fntInfo.scaleH = 100;
-    m_fntInfo.useSmoothing = true;
-    m_fntInfo.aa = 2;
-    m_fntInfo.paddingUp = 0;
-    m_fntInfo.paddingRight = 0;
-    m_fntInfo.paddingDown = 0;
-    m_fntInfo.paddingLeft = 0;
-    m_fntInfo.spacingHoriz = config.spacing_horiz;
-    m_fntInfo.spacingVert = config.spacing_vert;
-    m_fntInfo.outlineThickness = config.text_style.outline_thickness;
-    m_fntInfo.commonLineHeight = config.text_style.font_size + config.text_style.outline_thickness * 2 + config.glyph_padding_up + config.glyph_padding_down + config.line_height_padding_adcance;
-    m_fntInfo.base = config.text_style.font_size;
-    m_fntInfo.pages.clear();
+GenerateConfig FntGen::resolveRenderConfig(const GenerateConfig& config)
+{
+    GenerateConfig renderConfig = config;
+
+    if (isDistanceFieldMode(config))
+    {
+        // 距离场只需要文字形状, 描边、阴影、特效由运行时着色器实现
+        renderConfig.sdf_spread = std::max(config.sdf_spread, 1);
+        renderConfig.sdf_scale = std::max(config.sdf_scale, 1);
+        renderConfig.text_style.color = "#FFFFFFFF";
+        renderConfig.text_style.blend_mode.clear();
+        renderConfig.text_style.background_color = "#FFFFFF00";
+        renderConfig.text_style.effect = TextEffect();
+        renderConfig.text_style.shadows.clear();
+        renderConfig.text_style.outline_thickness = 0;
+        renderConfig.text_style.outline_effect = TextEffect();
+        renderConfig.text_style.outline_shadows.clear();
+        renderConfig.text_style.mask_effects.clear();
+        renderConfig.is_draw_debug = false;
+
+        // 字符四周预留距离场范围
+        renderConfig.glyph_padding_up += renderConfig.sdf_spread;
+        renderConfig.glyph_padding_down += renderConfig.sdf_spread;
+        renderConfig.glyph_padding_left += renderConfig.sdf_spread;
+        renderConfig.glyph_padding_right += renderConfig.sdf_spread;
+    }
+
+    // 页面图片格式, 编辑器预览始终使用彩色
+    bool monochrome = config.render_mode != "msdf" && isMonochromeStyle(renderConfig.text_style);
+    if (m_isEditorMode)
+    {
+        renderConfig.output_format = "rgba";
+    }
+    else if (renderConfig.output_format == "auto")
+    {
+        renderConfig.output_format = monochrome ? "a8" : "rgba";
+    }
+    else if (renderConfig.output_format == "a8")
+    {
+        if (config.render_mode == "msdf")
+        {
+            std::cerr << "msdf requires rgb channels, using rgba output" << std::endl;
+            renderConfig.output_format = "rgba";
+        }
+        else if (!monochrome)
+        {
+            std::cerr << "the text style is not monochrome, colors are dropped in a8 output" << std::endl;
+        }
+    }
+    else if (renderConfig.output_format == "layers")
+    {
+        if (isDistanceFieldMode(config))
+        {
+            std::cerr << "layers output requires bitmap render mode, using rgba output" << std::endl;
+            renderConfig.output_format = "rgba";
+        }
+    }
+    else
+    {
+        renderConfig.output_format = "rgba";
+    }
+
+    // 通道打包只适用于单通道输出
+    if (renderConfig.channel_packing)
+    {
+        if (m_isEditorMode)
+        {
+            renderConfig.channel_packing = false;
+        }
+        else if (renderConfig.output_format == "layers")
+        {
+            std::cerr << "channel_packing is not supported with layers output, disabled" << std::endl;
+            renderConfig.channel_packing = false;
+        }
+        else if (!monochrome)
+        {
+            std::cerr << "channel_packing requires a monochrome style, disabled" << std::endl;
+            renderConfig.channel_packing = false;
+        }
+        else
+        {
+            renderConfig.output_format = "a8";
+        }
+    }
+    return renderConfig;
+}
+
+bool FntGen::generate(const GenerateConfig& config)
+{
+    // 编辑模式直接预览配置的字体大小
+    if (config.fit_to.enabled && !m_isEditorMode)
+        return generate(fitFontSize(config));
+
+    initFntInfo(config);
 
     do
     {
@@ -78,9 +236,18 @@ bool FntGen::run(const GenerateConfig& config)
         // 匹配字体
         matchFont(config);
 
+        // 按字符使用频率重新分配页面
+        orderPagesByFrequency(config);
+
+        // 按最大高度拆分页面
+        splitPages(config);
+
         clock.update();
         printf("match font time: %.2fs(%dms)\n", clock.getDeltaTimeInSecs(), (int)clock.getDeltaTime());
 
+        // 排版
+        layout(config);
+
         // 生成图片
         if (!draw(config))
             break;
@@ -101,57 +268,318 @@ bool FntGen::run(const GenerateConfig& config)
     return false;
 }
 
+bool FntGen::planLayout(const GenerateConfig& config, const std::string& reportFile)
+{
+    if (config.fit_to.enabled)
+        return planLayout(fitFontSize(config), reportFile);
+
+    initFntInfo(config);
+
+    matchFont(config);
+    orderPagesByFrequency(config);
+    splitPages(config);
+    layout(config);
+
+    // 各格式下的显存估算(不含mipmap)
+    auto estimateMemory = [](int64_t width, int64_t height) {
+        int64_t blocks = ((width + 3) / 4) * ((height + 3) / 4);
+        return PlanMemory{
+            .rgba8888 = width * height * 4,
+            .rgba4444 = width * height * 2,
+            .a8 = width * height,
+            .etc2_rgba8 = blocks * 16,
+            .astc_4x4 = blocks * 16,
+        };
+    };
+
+    PlanReport report;
+    report.glyph_count = 0;
+    report.memory = PlanMemory{};
+    // 按纹理统计, 通道打包时同一纹理的多个页面合并为一项
+    size_t first = 0;
+    while (first < m_fntInfo.pages.size())
+    {
+        auto& texturePage = m_fntInfo.pages[first];
+        size_t last = first + 1;
+        if (config.channel_packing)
+        {
+            while (last < m_fntInfo.pages.size() && m_fntInfo.pages[last].texture == texturePage.texture)
+                ++last;
+        }
+
+        int glyphCount = 0;
+        int64_t glyphArea = 0;
+        int64_t pageArea = 0;
+        for (size_t pageIndex = first; pageIndex < last; ++pageIndex)
+        {
+            auto& page = m_fntInfo.pages[pageIndex];
+            for (auto& glyphInfo : page.glyphs)
+            {
+                glyphArea += (int64_t)glyphInfo.width * glyphInfo.height;
+            }
+            glyphCount += (int)page.glyphs.size();
+            // 打包时每个页面占用纹理的一个通道
+            pageArea += (int64_t)page.width * page.height;
+        }
+        first = last;
+
+        PlanPage planPage;
+        planPage.file = getBasename(texturePage.fileName);
+        planPage.width = texturePage.width;
+        planPage.height = texturePage.height;
+        planPage.glyph_count = glyphCount;
+        planPage.fill_ratio = pageArea > 0 ? float((double)glyphArea / (double)pageArea) : 0.0f;
+        planPage.memory = estimateMemory(texturePage.width, texturePage.height);
+        report.pages.push_back(planPage);
+
+        report.glyph_count += planPage.glyph_count;
+        report.memory.rgba8888 += planPage.memory.rgba8888;
+        report.memory.rgba4444 += planPage.memory.rgba4444;
+        report.memory.a8 += planPage.memory.a8;
+        report.memory.etc2_rgba8 += planPage.memory.etc2_rgba8;
+        report.memory.astc_4x4 += planPage.memory.astc_4x4;
+    }
+    for (auto codepoint : m_missingCodepoints)
+    {
+        report.missing_chars.push_back((uint32_t)codepoint);
+    }
+
+    if (!reportFile.empty())
+    {
+        try
+        {
+            ajson::save_to_file(report, reportFile.c_str());
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "failed to write file: " << reportFile << " " << e.what() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    for (auto& planPage : report.pages)
+    {
+        printf("page %s: %dx%d glyphs=%d fill=%.1f%% rgba8888=%.2fMB a8=%.2fMB etc2=%.2fMB astc4x4=%.2fMB\n",
+            planPage.file.c_str(), planPage.width, planPage.height, planPage.glyph_count, planPage.fill_ratio * 100.0f,
+            planPage.memory.rgba8888 / 1048576.0, planPage.memory.a8 / 1048576.0, planPage.memory.etc2_rgba8 / 1048576.0, planPage.memory.astc_4x4 / 1048576.0);
+    }
+    printf("total: pages=%d glyphs=%d rgba8888=%.2fMB rgba4444=%.2fMB a8=%.2fMB etc2=%.2fMB astc4x4=%.2fMB\n",
+        (int)report.pages.size(), report.glyph_count,
+        report.memory.rgba8888 / 1048576.0, report.memory.rgba4444 / 1048576.0, report.memory.a8 / 1048576.0, report.memory.etc2_rgba8 / 1048576.0, report.memory.astc_4x4 / 1048576.0);
+    if (!report.missing_chars.empty())
+    {
+        printf("missing chars(%d):", (int)report.missing_chars.size());
+        for (auto codepoint : report.missing_chars)
+            printf(" U+%04X", codepoint);
+        printf("\n");
+    }
+    return true;
+}
+
+GenerateConfig FntGen::fitFontSize(const GenerateConfig& config)
+{
+    Clock clock;
+
+    auto& fit = config.fit_to;
+
+    GenerateConfig fitConfig = config;
+    fitConfig.fit_to.enabled = false;
+    // 保留用户的 max_width/max_height, 适配的页面宽高单独记录
+    fitConfig.fitted_width = fit.width;
+    fitConfig.fitted_height = fit.height;
+
+    // 字体匹配与字体大小无关, 只匹配一次
+    initFntInfo(fitConfig);
+    matchFont(fitConfig);
+    auto matchedPages = m_fntInfo.pages;
+
+    // 使用频率表与字体大小无关, 只读取一次
+    std::unordered_map<char32_t, double> frequency;
+    if (!config.frequency_file.empty())
+        frequency = loadGlyphFrequency(config.frequency_file, config.frequency_format);
+
+    auto applyFontSize = [&](int fontSize) {
+        fitConfig.text_style.font_size = fontSize;
+        if (fit.fit_outline && config.text_style.font_size > 0)
+            fitConfig.text_style.outline_thickness = (int)std::lround((double)config.text_style.outline_thickness * fontSize / config.text_style.font_size);
+    };
+
+    // 二分查找能放下的最大字体大小
+    int low = std::max(fit.min_font_size, 1);
+    int high = std::max(fit.max_font_size, low);
+    int best = 0;
+    int tries = 0;
+    while (low <= high)
+    {
+        int mid = low + (high - low) / 2;
+        applyFontSize(mid);
+        ++tries;
+        if (isPagesFit(fitConfig, matchedPages, frequency))
+        {
+            best = mid;
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+
+    if (best == 0)
+    {
+        best = std::max(fit.min_font_size, 1);
+        std::cerr << "fit_to: min_font_size " << best << " does not fit in " << fit.max_pages << " page(s) of " << fit.width << "x" << fit.height << std::endl;
+    }
+    applyFontSize(best);
+
+    clock.update();
+    printf("fit font size: %d outline: %d (%d tries, %.2fs)\n", fitConfig.text_style.font_size, fitConfig.text_style.outline_thickness, tries, clock.getDeltaTimeInSecs());
+    return fitConfig;
+}
+
+bool FntGen::isPagesFit(const GenerateConfig& config, const std::vector<FntPage>& matchedPages, const std::unordered_map<char32_t, double>& frequency)
+{
+    initFntInfo(config);
+    m_fntInfo.pages = matchedPages;
+
+    // 按新的字体大小重新计算字符度量信息
+    for (auto& page : m_fntInfo.pages)
+    {
+        for (auto& glyphInfo : page.glyphs)
+        {
+            SkFont font = glyphInfo.font;
+            font.setSize(config.text_style.font_size);
+            auto pageIndex = glyphInfo.page;
+            glyphInfo = getGlyphInfo(font, glyphInfo.codepoint);
+            glyphInfo.page = pageIndex;
+        }
+    }
+
+    orderPagesByFrequency(config, frequency);
+    splitPages(config);
+    layout(config);
+
+    // 通道打包时多个页面共用一张纹理, 按纹理数量计算
+    int textureCount = (int)m_fntInfo.pages.size();
+    if (config.channel_packing && !m_fntInfo.pages.empty())
+        textureCount = m_fntInfo.pages.back().texture + 1;
+    if (textureCount > config.fit_to.max_pages)
+        return false;
+
+    for (auto& page : m_fntInfo.pages)
+    {
+        if (page.width > config.fit_to.width || page.height > config.fit_to.height)
+            return false;
+    }
+    return true;
+}
+
+void FntGen::initFntInfo(const GenerateConfig& config)
+{
+    m_outFileName = config.output_file;
+    if (m_outFileName.size() > 4 && _stricmp(m_outFileName.substr(m_outFileName.length() - 4).c_str(), ".fnt") == 0)
+        m_outFileName = m_outFileName.substr(0, m_outFileName.length() - 4);
+
+    m_fntInfo.fontSize = config.text_style.font_size;
+    m_fntInfo.isBold = config.text_style.is_bold;
+    m_fntInfo.isItalic = config.text_style.is_italic;
+    m_fntInfo.useUnicode = true;
+    m_fntInfo.scaleH = 100;
+    m_fntInfo.useSmoothing = true;
+    m_fntInfo.aa = 2;
+    m_fntInfo.paddingUp = 0;
+    m_fntInfo.paddingRight = 0;
+    m_fntInfo.paddingDown = 0;
+    m_fntInfo.paddingLeft = 0;
+    if (isDistanceFieldMode(config))
+    {
+        // 距离场范围, 运行时可据此还原字符实际区域
+        m_fntInfo.paddingUp = config.sdf_spread;
+        m_fntInfo.paddingRight = config.sdf_spread;
+        m_fntInfo.paddingDown = config.sdf_spread;
+        m_fntInfo.paddingLeft = config.sdf_spread;
+    }
+    m_fntInfo.spacingHoriz = config.spacing_horiz;
+    m_fntInfo.spacingVert = config.spacing_vert;
+    m_fntInfo.outlineThickness = config.text_style.outline_thickness;
+    m_fntInfo.commonLineHeight = config.text_style.font_size + config.text_style.outline_thickness * 2 + config.glyph_padding_up + config.glyph_padding_down + config.line_height_padding_adcance;
+    m_fntInfo.base = config.text_style.font_size;
+    m_fntInfo.pages.clear();
+    m_missingCodepoints.clear();
+}
+
 void FntGen::matchFont(const GenerateConfig& config)
 {
     // 获取系统默认的字体管理器
     sk_sp<SkFontMgr> fontMgr = SkFontMgr::RefDefault();
+    SkFontStyle fontStyle = getFontStyle(config.text_style.is_bold, config.text_style.is_italic);
+
+    // 字体文件或名称 -> 字体, 每个字体只加载一次
+    std::unordered_map<std::string, sk_sp<SkTypeface>> typefaces;
+    auto loadTypeface = [&](const std::string& font) {
+        auto it = typefaces.find(font);
+        if (it != typefaces.end())
+            return it->second;
+
+        sk_sp<SkTypeface> typeface = SkTypeface::MakeFromFile(font.c_str());
+        if (!typeface)
+            typeface = SkTypeface::MakeFromName(font.c_str(), fontStyle);
+        typefaces.emplace(font, typeface);
+        return typeface;
+    };
+
+    // 页面字体中第一个包含该字符的字体, 不使用系统字体回退
+    auto matchPageTypeface = [&](const PageConfig& pageCfg, char32_t codepoint) -> sk_sp<SkTypeface> {
+        for (auto& font : pageCfg.fonts)
+        {
+            if (font.empty())
+                continue;
+
+            sk_sp<SkTypeface> typeface = loadTypeface(font);
+            if (typeface && typeface->unicharToGlyph((SkUnichar)codepoint) != 0)
+                return typeface;
+        }
+        return nullptr;
+    };
+
+    // 跨页面去重后的字符, 相同字符归属于字体实际包含该字符的页面
+    auto pagesCodepoints = collectPagesCodepoints(config, [&](size_t pageIndex, char32_t codepoint) {
+        return matchPageTypeface(config.pages[pageIndex], codepoint) != nullptr;
+    });
     for (size_t i = 0; i < config.pages.size(); ++i)
     {
-        if (m_isEditorMode && m_editorShowPageIndex != i)
+        if (m_isEditorMode && m_editorShowPageIndex != (int)i)
         {
             m_fntInfo.pages.push_back(FntPage{
+                .fixed_width_alignment = false,
                 .width = 0,
                 .height = 0,
                 .glyphs = {},
                 .fileName = "",
+                .texture = 0,
+                .packed_channel = 0,
+                .split_source = -1,
             });
             continue;
         }
         auto& pageCfg = config.pages[i];
 
         std::vector<GlyphInfo> glyphs;
-        for (auto& codepoint : collectCodepoints(pageCfg))
+        for (auto& codepoint : pagesCodepoints[i])
         {
-            sk_sp<SkTypeface> typeface;
-            for (auto& font : pageCfg.fonts)
-            {
-                if (!font.empty())
-                {
-                    typeface = SkTypeface::MakeFromFile(font.c_str());
-                    if (!typeface)
-                    {
-                        typeface = SkTypeface::MakeFromName(font.c_str(), getFontStyle(config.text_style.is_bold, config.text_style.is_italic));
-                    }
-                }
-
-                if (typeface->unicharToGlyph((SkUnichar)codepoint) == 0)
-                {
-                    typeface = nullptr;
-                }
-
-                if (typeface)
-                    break;
-            }
+            sk_sp<SkTypeface> typeface = matchPageTypeface(pageCfg, codepoint);
 
             if (!typeface)
             {
-                typeface = fontMgr->matchFamilyStyleCharacter(nullptr, getFontStyle(config.text_style.is_bold, config.text_style.is_italic), nullptr, 0, codepoint);
+                typeface = fontMgr->matchFamilyStyleCharacter(nullptr, fontStyle, nullptr, 0, codepoint);
 
                 if (!typeface)
                 {
                     if (codepoint != char32_t(10))
                     {
                         std::cerr << "No matching font found for character: " << int(codepoint) << std::endl;
+                        m_missingCodepoints.push_back(codepoint);
                     }
                 }
             }
@@ -163,7 +591,8 @@ void FntGen::matchFont(const GenerateConfig& config)
                 font.setTypeface(typeface);
 
                 auto glyph = getGlyphInfo(font, codepoint);
-                glyph.page = (int)i;
+                // 空页面不会输出, 页面编号以实际输出的页面为准
+                glyph.page = (int)m_fntInfo.pages.size();
                 glyphs.push_back(glyph);
             }
         }
@@ -176,90 +605,341 @@ void FntGen::matchFont(const GenerateConfig& config)
                 .height = 0,
                 .glyphs = glyphs,
                 .fileName = "",
+                .texture = 0,
+                .packed_channel = 0,
+                .split_source = -1,
                 });
         }
     }
 }
 
-
-bool FntGen::draw(const GenerateConfig& config)
+void FntGen::orderPagesByFrequency(const GenerateConfig& config)
 {
-    m_maxOffsetY = 0;
-    for (size_t pageIndex = 0; pageIndex < m_fntInfo.pages.size(); ++pageIndex)
-    {
-        if (m_isEditorMode && m_editorShowPageIndex != pageIndex)
-            continue;
+    // 编辑模式只预览单个页面
+    if (m_isEditorMode || config.frequency_file.empty())
+        return;
 
-        auto& page = m_fntInfo.pages[pageIndex];
-
-        initPageData(config, page, pageIndex);
-        if (!drawPage(config, page))
-            return false;
-    }
-    return true;
+    orderPagesByFrequency(config, loadGlyphFrequency(config.frequency_file, config.frequency_format));
 }
 
-void FntGen::initPageData(const GenerateConfig& config, FntPage& page, int pageIndex)
+void FntGen::orderPagesByFrequency(const GenerateConfig& config, const std::unordered_map<char32_t, double>& frequency)
 {
-    if (m_fntInfo.pages.size() > 1)
-        page.fileName = stringFormat("%s%d.png", m_outFileName.c_str(), pageIndex);
-    else
-        page.fileName = stringFormat("%s.png", m_outFileName.c_str());
+    if (m_isEditorMode || frequency.empty())
+        return;
 
+    // 合并所有页面的字符后按使用频率从高到低排序, 频率相同时保持原有顺序
+    std::vector<GlyphInfo> glyphs;
+    for (auto& page : m_fntInfo.pages)
+    {
+        glyphs.insert(glyphs.end(), page.glyphs.begin(), page.glyphs.end());
+    }
 
+    auto getFrequency = [&](char32_t codepoint) {
+        auto it = frequency.find(codepoint);
+        return it == frequency.end() ? 0.0 : it->second;
+    };
+    std::stable_sort(glyphs.begin(), glyphs.end(), [&](const GlyphInfo& a, const GlyphInfo& b) {
+        return getFrequency(a.codepoint) > getFrequency(b.codepoint);
+    });
 
-    for (auto& glyphInfo : page.glyphs)
+    if (pageMaxHeight(config) > 0)
     {
-        glyphInfo.padding_up = 0;
-        glyphInfo.padding_down = 0;
-        glyphInfo.padding_left = 0;
-        glyphInfo.padding_right = 0;
+        // 由splitPages按最大高度拆分, 页面设置使用第一个页面
+        m_fntInfo.pages.resize(1);
+        m_fntInfo.pages[0].glyphs = std::move(glyphs);
     }
-
-    if (page.fixed_width_alignment)
+    else
     {
-        // 找到本页字符最大宽高
-        int maxGlyphWidth = 0;
-        int maxGlyphHeight = 0;
-        for (auto& glyphInfo : page.glyphs)
+        // 各页面保持原有字符数量和设置, 只调整页面包含的字符
+        size_t offset = 0;
+        for (auto& page : m_fntInfo.pages)
         {
-            if (glyphInfo.width > maxGlyphWidth)
-                maxGlyphWidth = glyphInfo.width;
-            if (glyphInfo.height > maxGlyphHeight)
-                maxGlyphHeight = glyphInfo.height;
+            auto count = page.glyphs.size();
+            page.glyphs.assign(glyphs.begin() + offset, glyphs.begin() + offset + count);
+            offset += count;
         }
+    }
+}
 
-        // 计算每个字符的偏移量
-        for (auto& glyphInfo : page.glyphs)
-        {
-            auto diffWidth = maxGlyphWidth - glyphInfo.width;
-            glyphInfo.padding_left = diffWidth / 2;
-            glyphInfo.padding_right = diffWidth - glyphInfo.padding_left;
-            
-            //auto diffHeight = maxGlyphHeight - glyphInfo.height;
-            //glyphInfo.padding_down = diffHeight / 2;
-            //glyphInfo.padding_up = diffHeight - glyphInfo.padding_down;
-        }
+void FntGen::splitPages(const GenerateConfig& config)
+{
+    // 编辑模式只预览单个页面
+    if (m_isEditorMode)
+        return;
+
+    bool balanced = config.page_split_mode == "balanced";
+    if (!balanced && config.page_split_mode != "fill")
+    {
+        std::cerr << "invalid page_split_mode: " << config.page_split_mode << ", using fill" << std::endl;
     }
 
-    // 计算最适合的最大宽度
-    int maxWidth = 0;
-    for (int x = 2;;)
+    int maxWidth = pageMaxWidth(config);
+    int maxHeight = pageMaxHeight(config);
+    if (maxHeight > 0)
     {
-        auto max = x;
-        if (config.is_NPOT)
+        std::vector<FntPage> pages;
+        for (size_t pageIndex = 0; pageIndex < m_fntInfo.pages.size(); ++pageIndex)
         {
-            max = nextPOT(max);
+            auto& page = m_fntInfo.pages[pageIndex];
+            // 固定宽度对齐时按整页最大字符宽度预留间距, 拆分后的页面只会更小
+            initGlyphPadding(page);
+
+            std::vector<size_t> counts;
+            for (size_t first = 0; first < page.glyphs.size(); first += counts.back())
+            {
+                counts.push_back(fitGlyphCount(page.glyphs, first, config, maxWidth, maxHeight));
+            }
+
+            if (balanced && counts.size() > 1)
+            {
+                // 从最少页面数开始均分, 均分后放不下则增加页面数
+                for (auto pageCount = counts.size();; ++pageCount)
+                {
+                    auto balancedCounts = balanceGlyphCounts(page.glyphs, config, pageCount);
+
+                    bool fit = true;
+                    size_t first = 0;
+                    for (auto count : balancedCounts)
+                    {
+                        if (fitGlyphCount(page.glyphs, first, config, maxWidth, maxHeight) < count)
+                        {
+                            fit = false;
+                            break;
+                        }
+                        first += count;
+                    }
+
+                    if (fit)
+                    {
+                        counts = std::move(balancedCounts);
+                        break;
+                    }
+                }
+            }
+
+            size_t first = 0;
+            for (auto count : counts)
+            {
+                pages.push_back(FntPage{
+                    .fixed_width_alignment = page.fixed_width_alignment,
+                    .width = 0,
+                    .height = 0,
+                    .glyphs = std::vector<GlyphInfo>(page.glyphs.begin() + first, page.glyphs.begin() + first + count),
+                    .fileName = "",
+                    .texture = 0,
+                    .packed_channel = 0,
+                    .split_source = counts.size() > 1 ? (int)pageIndex : -1,
+                    });
+                first += count;
+            }
+        }
+        m_fntInfo.pages = std::move(pages);
+    }
+
+    // 通道打包时单个页面按占用面积均分到4个通道
+    if (config.channel_packing && m_fntInfo.pages.size() == 1 && m_fntInfo.pages[0].glyphs.size() >= 4)
+    {
+        auto& page = m_fntInfo.pages[0];
+        initGlyphPadding(page);
+
+        std::vector<FntPage> pages;
+        size_t first = 0;
+        for (auto count : balanceGlyphCounts(page.glyphs, config, 4))
+        {
+            pages.push_back(FntPage{
+                .fixed_width_alignment = page.fixed_width_alignment,
+                .width = 0,
+                .height = 0,
+                .glyphs = std::vector<GlyphInfo>(page.glyphs.begin() + first, page.glyphs.begin() + first + count),
+                .fileName = "",
+                .texture = 0,
+                .packed_channel = 0,
+                .split_source = -1,
+                });
+            first += count;
+        }
+        m_fntInfo.pages = std::move(pages);
+    }
+
+    for (size_t pageIndex = 0; pageIndex < m_fntInfo.pages.size(); ++pageIndex)
+    {
+        for (auto& glyphInfo : m_fntInfo.pages[pageIndex].glyphs)
+        {
+            glyphInfo.page = (int)pageIndex;
+        }
+    }
+}
+
+void FntGen::layout(const GenerateConfig& config)
+{
+    m_maxOffsetY = 0;
+    for (size_t pageIndex = 0; pageIndex < m_fntInfo.pages.size(); ++pageIndex)
+    {
+        if (m_isEditorMode && m_editorShowPageIndex != (int)pageIndex)
+            continue;
+
+        initPageData(config, m_fntInfo.pages[pageIndex], pageIndex);
+    }
+
+    // 均分模式同一页面拆分出的页面使用相同的宽高, 未拆分的页面不变
+    if (config.page_split_mode == "balanced" && !m_isEditorMode)
+    {
+        std::unordered_map<int, std::pair<int, int>> splitSizes;
+        for (auto& page : m_fntInfo.pages)
+        {
+            if (page.split_source < 0)
+                continue;
+            auto& size = splitSizes[page.split_source];
+            size.first = std::max(size.first, page.width);
+            size.second = std::max(size.second, page.height);
+        }
+        for (auto& page : m_fntInfo.pages)
+        {
+            if (page.split_source < 0)
+                continue;
+            auto& size = splitSizes[page.split_source];
+            page.width = size.first;
+            page.height = size.second;
+        }
+    }
+
+    if (config.channel_packing)
+        packChannels();
+
+    for (size_t pageIndex = 0; pageIndex < m_fntInfo.pages.size(); ++pageIndex)
+    {
+        if (m_isEditorMode && m_editorShowPageIndex != (int)pageIndex)
+            continue;
+
+        layoutGlyphs(config, m_fntInfo.pages[pageIndex]);
+    }
+}
+
+void FntGen::packChannels()
+{
+    // 每4个页面共用一张纹理, 依次使用R、G、B、A通道
+    // fnt中 chnl: 1 蓝, 2 绿, 4 红, 8 透明度
+    const int channelBits[4] = { 4, 2, 1, 8 };
+    int textureCount = (int)(m_fntInfo.pages.size() + 3) / 4;
+    for (int texture = 0; texture < textureCount; ++texture)
+    {
+        size_t first = texture * 4;
+        size_t last = std::min(first + 4, m_fntInfo.pages.size());
+
+        int width = 0;
+        int height = 0;
+        for (size_t pageIndex = first; pageIndex < last; ++pageIndex)
+        {
+            width = std::max(width, m_fntInfo.pages[pageIndex].width);
+            height = std::max(height, m_fntInfo.pages[pageIndex].height);
+        }
+
+        for (size_t pageIndex = first; pageIndex < last; ++pageIndex)
+        {
+            auto& page = m_fntInfo.pages[pageIndex];
+            page.width = width;
+            page.height = height;
+            page.texture = texture;
+            page.packed_channel = (int)(pageIndex - first) + 1;
+            page.fileName = getPageFileName(texture, textureCount);
+
+            for (auto& glyphInfo : page.glyphs)
+            {
+                glyphInfo.page = texture;
+                glyphInfo.chnl = channelBits[page.packed_channel - 1];
+            }
+        }
+    }
+}
+
+bool FntGen::draw(const GenerateConfig& config)
+{
+    // 绘制前编译渲染样式, 各线程共享
+    m_renderStyle.compile(config);
+
+    // 轮廓缓存在编辑器多次渲染之间保留, 数量过多时清空
+    if (m_pathCache.size() > 65536)
+        m_pathCache.clear();
+
+    if (config.channel_packing)
+        return drawPackedTextures(config);
+
+    // 是否使用GPU只在所属线程判断一次, 工作线程不访问opengl上下文
+    bool useGPU = useGPURendering(config);
+
+    // GPU渲染及编辑器模式逐页绘制
+    if (m_isEditorMode || useGPU || m_fntInfo.pages.size() <= 1)
+    {
+        for (size_t pageIndex = 0; pageIndex < m_fntInfo.pages.size(); ++pageIndex)
+        {
+            if (m_isEditorMode && m_editorShowPageIndex != (int)pageIndex)
+                continue;
+
+            if (!drawPage(config, m_fntInfo.pages[pageIndex], useGPU))
+                return false;
+        }
+        return true;
+    }
+
+    // CPU渲染时页面之间互不依赖, 多个页面并行绘制并保存
+    // 按内存预算分批, 每批至少包含一个页面
+    int64_t budget = (int64_t)config.render_memory_budget * 1024 * 1024;
+    size_t first = 0;
+    while (first < m_fntInfo.pages.size())
+    {
+        size_t last = first;
+        int64_t memory = 0;
+        while (last < m_fntInfo.pages.size())
+        {
+            auto& page = m_fntInfo.pages[last];
+            int64_t pageMemory = (int64_t)makePageImageInfo(config, page.width, page.height).computeMinByteSize();
+            if (budget > 0 && last > first && memory + pageMemory > budget)
+                break;
+            memory += pageMemory;
+            ++last;
+        }
+
+        std::vector<char> results(last - first, 0);
+        async::parallel_for(async::irange(first, last), [&](size_t pageIndex) {
+            results[pageIndex - first] = drawPage(config, m_fntInfo.pages[pageIndex], false) ? 1 : 0;
+        });
+
+        for (auto result : results)
+        {
+            if (!result)
+                return false;
+        }
+        first = last;
+    }
+    return true;
+}
+
+void FntGen::initPageData(const GenerateConfig& config, FntPage& page, int pageIndex)
+{
+    initPageFileName(page, pageIndex);
+
+
+    initGlyphPadding(page);
+
+    // 计算最适合的最大宽度
+    int maxWidth = 0;
+    for (int x = 2;;)
+    {
+        auto max = x;
+        if (config.is_NPOT)
+        {
+            max = nextPOT(max);
         }
         if (max > getMinWidth(page, config))
         {
-            if (max > config.max_width)
+            if (max > pageMaxWidth(config))
             {
                 maxWidth = max;
                 break;
             }
 
-            if (calculateHeight(page, config, max) <= max)
+            auto height = calculateHeight(page, config, max);
+            if (height <= max && (pageMaxHeight(config) <= 0 || height <= pageMaxHeight(config)))
             {
                 maxWidth = max;
                 break;
@@ -268,19 +948,66 @@ void FntGen::initPageData(const GenerateConfig& config, FntPage& page, int pageI
 
         x *= 2;
     }
-    if (maxWidth > config.max_width)
-        maxWidth = config.max_width;
+    if (maxWidth > pageMaxWidth(config))
+        maxWidth = pageMaxWidth(config);
 
     // 计算本页宽高
     page.width = maxWidth;
     page.height = calculateHeight(page, config, maxWidth);
 }
 
-bool FntGen::drawPage(const GenerateConfig& config, FntPage& page)
+void FntGen::initPageFileName(FntPage& page, int pageIndex)
 {
-    bool useGPU = supportGPU();
+    page.fileName = getPageFileName(pageIndex, (int)m_fntInfo.pages.size());
+}
 
-    if (useGPU && config.use_gpu)
+std::string FntGen::getPageFileName(int pageIndex, int pageCount)
+{
+    if (pageCount > 1)
+        return stringFormat("%s%d.png", m_outFileName.c_str(), pageIndex);
+    return stringFormat("%s.png", m_outFileName.c_str());
+}
+
+void FntGen::initGlyphPadding(FntPage& page)
+{
+    for (auto& glyphInfo : page.glyphs)
+    {
+        glyphInfo.padding_up = 0;
+        glyphInfo.padding_down = 0;
+        glyphInfo.padding_left = 0;
+        glyphInfo.padding_right = 0;
+    }
+
+    if (page.fixed_width_alignment)
+    {
+        // 找到本页字符最大宽高
+        int maxGlyphWidth = 0;
+        int maxGlyphHeight = 0;
+        for (auto& glyphInfo : page.glyphs)
+        {
+            if (glyphInfo.width > maxGlyphWidth)
+                maxGlyphWidth = glyphInfo.width;
+            if (glyphInfo.height > maxGlyphHeight)
+                maxGlyphHeight = glyphInfo.height;
+        }
+
+        // 计算每个字符的偏移量
+        for (auto& glyphInfo : page.glyphs)
+        {
+            auto diffWidth = maxGlyphWidth - glyphInfo.width;
+            glyphInfo.padding_left = diffWidth / 2;
+            glyphInfo.padding_right = diffWidth - glyphInfo.padding_left;
+            
+            //auto diffHeight = maxGlyphHeight - glyphInfo.height;
+            //glyphInfo.padding_down = diffHeight / 2;
+            //glyphInfo.padding_up = diffHeight - glyphInfo.padding_down;
+        }
+    }
+}
+
+bool FntGen::drawPage(const GenerateConfig& config, FntPage& page, bool useGPU)
+{
+    if (useGPU)
     {
         // 查询最大纹理尺寸
         GLint maxTextureSize = 0;
@@ -348,7 +1075,10 @@ bool FntGen::drawPage(const GenerateConfig& config, FntPage& page)
         assert(surface != nullptr);
 
         auto canvas = surface->getCanvas();
-        drawGlyphs(config, page, canvas);
+        if (config.render_engine == "sprite")
+            drawGlyphsSprite(config, page, canvas);
+        else
+            drawGlyphs(config, page, canvas, SkIRect::MakeWH(page.width, page.height));
         surface->flushAndSubmit();
 
         if (m_isEditorMode)
@@ -360,7 +1090,8 @@ bool FntGen::drawPage(const GenerateConfig& config, FntPage& page)
         }
         else
         {
-            SkImageInfo imageInfo = SkImageInfo::Make(page.width, page.height, kRGBA_8888_SkColorType, kUnpremul_SkAlphaType);
+            // a8 输出时只读取透明度
+            SkImageInfo imageInfo = makePageImageInfo(config, page.width, page.height);
             SkBitmap bitmap;
             bitmap.allocPixels(imageInfo, imageInfo.minRowBytes());
 
@@ -380,12 +1111,11 @@ bool FntGen::drawPage(const GenerateConfig& config, FntPage& page)
     {
         std::cout << "Rendering with CPU" << std::endl;
 
-        SkImageInfo imageInfo = SkImageInfo::Make(page.width, page.height, kRGBA_8888_SkColorType, kUnpremul_SkAlphaType);
+        SkImageInfo imageInfo = makePageImageInfo(config, page.width, page.height);
         SkBitmap bitmap;
         bitmap.allocPixels(imageInfo, imageInfo.minRowBytes());
 
-        SkCanvas cv(bitmap);
-        drawGlyphs(config, page, &cv);
+        drawPageBitmap(config, page, bitmap);
 
         if (m_isEditorMode)
         {
@@ -412,6 +1142,70 @@ bool FntGen::drawPage(const GenerateConfig& config, FntPage& page)
     return true;
 }
 
+void FntGen::drawPageBitmap(const GenerateConfig& config, const FntPage& page, SkBitmap& bitmap)
+{
+    if (isDistanceFieldMode(config))
+    {
+        drawGlyphsDistanceField(config, page, bitmap);
+    }
+    else if (config.output_format == "layers")
+    {
+        drawGlyphsLayered(config, page, bitmap);
+    }
+    else if (config.render_engine == "sprite")
+    {
+        SkCanvas canvas(bitmap);
+        drawGlyphsSprite(config, page, &canvas);
+    }
+    else
+    {
+        drawGlyphsBanded(config, page, bitmap);
+    }
+}
+
+bool FntGen::drawPackedTextures(const GenerateConfig& config)
+{
+    std::cout << "Rendering with CPU (channel packing)" << std::endl;
+
+    size_t first = 0;
+    while (first < m_fntInfo.pages.size())
+    {
+        auto& texturePage = m_fntInfo.pages[first];
+        size_t last = first;
+        while (last < m_fntInfo.pages.size() && m_fntInfo.pages[last].texture == texturePage.texture)
+            ++last;
+
+        SkImageInfo imageInfo = SkImageInfo::Make(texturePage.width, texturePage.height, kRGBA_8888_SkColorType, kUnpremul_SkAlphaType);
+        SkBitmap texture;
+        texture.allocPixels(imageInfo, imageInfo.minRowBytes());
+        texture.eraseColor(SK_ColorTRANSPARENT);
+
+        // 各页面单独绘制为单通道位图, 再写入纹理对应的通道
+        SkBitmap bitmap;
+        bitmap.allocPixels(makePageImageInfo(config, texturePage.width, texturePage.height));
+        for (size_t pageIndex = first; pageIndex < last; ++pageIndex)
+        {
+            auto& page = m_fntInfo.pages[pageIndex];
+            drawPageBitmap(config, page, bitmap);
+
+            int offset = page.packed_channel - 1;
+            for (int y = 0; y < page.height; ++y)
+            {
+                const uint8_t* src = bitmap.getAddr8(0, y);
+                uint8_t* dst = (uint8_t*)texture.getAddr(0, y);
+                for (int x = 0; x < page.width; ++x)
+                    dst[x * 4 + offset] = src[x];
+            }
+        }
+
+        if (!saveBitmapToFile(texturePage.fileName, texture))
+            return false;
+
+        first = last;
+    }
+    return true;
+}
+
 bool FntGen::saveBitmapToFile(const std::string& filename, SkBitmap& bitmap)
 {
     SkFILEWStream file(filename.c_str());
@@ -420,7 +1214,12 @@ bool FntGen::saveBitmapToFile(const std::string& filename, SkBitmap& bitmap)
         std::cerr << "failed to open file: " << filename;
         return false;
     }
-    if (!SkPngEncoder::Encode(&file, bitmap.pixmap(), {}))
+    // 单通道位图保存为灰度图片
+    SkPixmap pixmap = bitmap.pixmap();
+    if (pixmap.colorType() == kAlpha_8_SkColorType)
+        pixmap.reset(pixmap.info().makeColorType(kGray_8_SkColorType).makeAlphaType(kOpaque_SkAlphaType), pixmap.addr(), pixmap.rowBytes());
+
+    if (!SkPngEncoder::Encode(&file, pixmap, {}))
     {
         std::cerr << "failed to write file: " << filename;
         return false;
@@ -428,28 +1227,8 @@ bool FntGen::saveBitmapToFile(const std::string& filename, SkBitmap& bitmap)
     return true;
 }
 
-void FntGen::drawGlyphs(const GenerateConfig& config, FntPage& page, SkCanvas* canvas)
+void FntGen::layoutGlyphs(const GenerateConfig& config, FntPage& page)
 {
-    canvas->clear(stringToSkColor(config.text_style.background_color));
-
-    // 描边阴影画笔
-    std::vector<SkPaint> outlineShadowPaints = createShadowPaints(config.text_style.outline_shadows);
-    // 文字描边画笔
-    SkPaint outlinePaint = createPaint(config.text_style.outline_color, config.text_style.outline_blend_mode);
-    outlinePaint.setStyle(SkPaint::kStroke_Style);
-    outlinePaint.setStrokeWidth(config.text_style.outline_thickness <= 0 ? 1 : config.text_style.outline_thickness * config.text_style.outline_thickness_render_scale);
-
-    // 描边阴影画笔
-    std::vector<SkPaint> textShadowPaints = createShadowPaints(config.text_style.shadows);
-    // 文字画笔
-    SkPaint textPaint = createPaint(config.text_style.color, config.text_style.blend_mode);
-
-    // 调试画笔
-    SkPaint debugPaint;
-    debugPaint.setAntiAlias(true);                // 开启抗锯齿
-    debugPaint.setStyle(SkPaint::kStroke_Style);  // 设置为描边模式
-    debugPaint.setStrokeWidth(1);                 // 设置描边宽度
-
     // 字符增加的宽高
     int glyhMargin = config.text_style.outline_thickness;
 
@@ -479,80 +1258,11 @@ void FntGen::drawGlyphs(const GenerateConfig& config, FntPage& page, SkCanvas* c
         glyphInfo.x = x;
         glyphInfo.y = y;
 
-        // 绘制相关逻辑
-        {
-            SkScalar drawx = x + glyhMargin + glyphInfo.padding_left + config.glyph_padding_left - glyphInfo.xoffset;
-            SkScalar drawy = y + glyhMargin + glyphInfo.padding_up + config.glyph_padding_up + glyphInfo.height - glyphInfo.yoffset;
-
-            SkScalar w = (SkScalar)glyphInfo.width;
-            SkScalar h = (SkScalar)glyphInfo.height;
-
-            // 描边绘制
-            if (config.text_style.outline_thickness > 0)
-            {
-                // 描边阴影
-                for (size_t index = 0; index < outlineShadowPaints.size(); ++index)
-                {
-                    auto& shadowPaint = outlineShadowPaints[index];
-                    //setPaintShader(shadowPaint, config.text_style.outline_shadows[index].effect, drawx, drawy - h, w, h);
-                    canvas->drawSimpleText(&glyphInfo.codepoint, sizeof(glyphInfo.codepoint), SkTextEncoding::kUTF32, drawx, drawy, glyphInfo.font, shadowPaint);
-                }
-
-                setPaintShader(outlinePaint, config.text_style.outline_effect, drawx, drawy - h, w, h);
-                canvas->drawSimpleText(&glyphInfo.codepoint, sizeof(glyphInfo.codepoint), SkTextEncoding::kUTF32, drawx, drawy, glyphInfo.font, outlinePaint);
-            }
-
-            // 文字阴影
-            for (size_t index = 0; index < textShadowPaints.size(); ++index)
-            {
-                auto& shadowPaint = textShadowPaints[index];
-                //setPaintShader(shadowPaint, config.text_style.shadows[index].effect, drawx, drawy - h, w, h);
-                canvas->drawSimpleText(&glyphInfo.codepoint, sizeof(glyphInfo.codepoint), SkTextEncoding::kUTF32, drawx, drawy, glyphInfo.font, shadowPaint);
-            }
-
-            // 文字绘制
-            setPaintShader(textPaint, config.text_style.effect, drawx, drawy - h, w, h);
-            canvas->drawSimpleText(&glyphInfo.codepoint, sizeof(glyphInfo.codepoint), SkTextEncoding::kUTF32, drawx, drawy, glyphInfo.font, textPaint);
-
-            if (config.is_draw_debug)
-            {
-                // 绘制字符全部区域
-                if (config.is_debug_draw_glyph_all_area)
-                {
-                    if (config.glyph_padding_left != 0 || config.glyph_padding_right != 0 || config.glyph_padding_up != 0 || config.glyph_padding_down != 0)
-                    {
-                        // 绘制字符不带描边区域
-                        SkRect rect = SkRect::MakeXYWH(x, y, glyphRealWidth, glyphRealHeight);
-                        debugPaint.setColor(stringToSkColor(config.color_debug_draw_glyph_all_area));
-                        canvas->drawRect(rect, debugPaint);
-                    }
-                }
-
-                if (config.is_debug_draw_glyph_real_area)
-                {
-                    // 绘制字符实际区域
-                    SkRect rect = SkRect::MakeXYWH(x + config.glyph_padding_left, y + config.glyph_padding_up, glyphWidth + glyphInfo.padding_left + glyphInfo.padding_right, glyphHeight + glyphInfo.padding_up + glyphInfo.padding_down);
-                    debugPaint.setColor(stringToSkColor(config.color_debug_draw_glyph_real_area));
-                    canvas->drawRect(rect, debugPaint);
-                }
-
-                // 绘制字符+描边区域
-                if (config.is_debug_draw_glyph_outline_thickness_area && config.text_style.outline_thickness > 0)
-                {
-                    SkRect rect = SkRect::MakeXYWH(x + config.glyph_padding_left + glyphInfo.padding_left, y + config.glyph_padding_up + glyphInfo.padding_up, glyphWidth, glyphHeight);
-                    debugPaint.setColor(stringToSkColor(config.color_debug_draw_glyph_outline_thickness_area));
-                    canvas->drawRect(rect, debugPaint);
-                }
-
-                if (config.is_debug_draw_glyph_raw_area)
-                {
-                    // 绘制字符不带描边区域
-                    SkRect rect = SkRect::MakeXYWH(x + config.glyph_padding_left + glyphInfo.padding_left + glyhMargin, y + config.glyph_padding_up + glyphInfo.padding_up + glyhMargin, glyphInfo.width, glyphInfo.height);
-                    debugPaint.setColor(stringToSkColor(config.color_debug_draw_glyph_raw_area));
-                    canvas->drawRect(rect, debugPaint);
-                }
-            }
-        }
+        // 绘制位置
+        glyphInfo.draw_x = (SkScalar)(x + glyhMargin + glyphInfo.padding_left + config.glyph_padding_left - glyphInfo.xoffset);
+        glyphInfo.draw_y = (SkScalar)(y + glyhMargin + glyphInfo.padding_up + config.glyph_padding_up + glyphInfo.height - glyphInfo.yoffset);
+        glyphInfo.raw_width = glyphInfo.width;
+        glyphInfo.raw_height = glyphInfo.height;
 
         x += glyphRealWidth;
         x += config.spacing_glyph_x;
@@ -607,10 +1317,671 @@ void FntGen::drawGlyphs(const GenerateConfig& config, FntPage& page, SkCanvas* c
             glyphInfo.xadvance = maxXadvance;
         }
     }
+}
+
+void FntGen::drawGlyphsBanded(const GenerateConfig& config, const FntPage& page, SkBitmap& bitmap)
+{
+    int threads = config.render_threads > 0 ? config.render_threads : (int)async::hardware_concurrency();
+
+    // 每个线程分配多个条带以平衡负载, 条带高度不低于32像素
+    int bandCount = std::min(threads * 4, page.height / 32);
+    if (threads <= 1 || bandCount <= 1)
+    {
+        SkCanvas canvas(bitmap);
+        drawGlyphs(config, page, &canvas, SkIRect::MakeWH(page.width, page.height));
+        return;
+    }
+
+    async::parallel_for(async::irange(0, bandCount), [&](int band) {
+        int top = page.height * band / bandCount;
+        int bottom = page.height * (band + 1) / bandCount;
+        SkIRect bounds = SkIRect::MakeLTRB(0, top, page.width, bottom);
+
+        // 条带位图与页面位图共享像素内存
+        SkBitmap bandBitmap;
+        if (!bitmap.extractSubset(&bandBitmap, bounds))
+            return;
+
+        // 跨越条带边界的字符在相关条带中都会绘制, 由条带边界裁剪
+        SkCanvas canvas(bandBitmap);
+        canvas.translate(0, (SkScalar)-top);
+        drawGlyphs(config, page, &canvas, bounds);
+    });
+}
+
+void FntGen::drawGlyphsSprite(const GenerateConfig& config, const FntPage& page, SkCanvas* canvas)
+{
+    auto& paints = m_renderStyle.paints();
+
+    canvas->clear(paints.backgroundColor);
+
+    struct GlyphSprite
+    {
+        sk_sp<SkImage> image;
+        SkIPoint origin;
+    };
+
+    // 分批绘制, 限制同时存在的精灵图数量
+    const size_t batchSize = 256;
+    std::vector<GlyphSprite> sprites;
+    for (size_t first = 0; first < page.glyphs.size(); first += batchSize)
+    {
+        size_t count = std::min(batchSize, page.glyphs.size() - first);
+        sprites.assign(count, GlyphSprite{});
+
+        // 每个字符(含阴影、描边、文字)在独立的位图中绘制, 互不依赖
+        async::parallel_for(async::irange((size_t)0, count), [&](size_t index) {
+            auto& glyphInfo = page.glyphs[first + index];
+            SkIRect rect = SkIRect::MakeXYWH(glyphInfo.x, glyphInfo.y, glyphInfo.width, glyphInfo.height).makeOutset(paints.overflow, paints.overflow);
+
+            SkBitmap bitmap;
+            bitmap.allocPixels(SkImageInfo::MakeN32Premul(rect.width(), rect.height()));
+            bitmap.eraseColor(SK_ColorTRANSPARENT);
+
+            SkCanvas spriteCanvas(bitmap);
+            spriteCanvas.translate((SkScalar)-rect.left(), (SkScalar)-rect.top());
+            drawGlyph(config, glyphInfo, &spriteCanvas, paints);
+            bitmap.setImmutable();
+
+            sprites[index].image = bitmap.asImage();
+            sprites[index].origin = rect.topLeft();
+        });
+
+        // 按字符顺序合成, 结果与线程数无关
+        for (auto& sprite : sprites)
+        {
+            canvas->drawImage(sprite.image, (SkScalar)sprite.origin.x(), (SkScalar)sprite.origin.y());
+        }
+    }
+
+    if (config.is_draw_debug)
+    {
+        for (auto& glyphInfo : page.glyphs)
+        {
+            drawGlyphDebug(config, glyphInfo, canvas, paints);
+        }
+    }
 
     canvas->flush();
 }
 
+void FntGen::drawGlyphsDistanceField(const GenerateConfig& config, const FntPage& page, SkBitmap& bitmap)
+{
+    bool multiChannel = config.render_mode == "msdf";
+    int scale = config.sdf_scale;
+    float spread = (float)config.sdf_spread;
+
+    // sdf 写入alpha通道, msdf 写入RGB通道
+    bitmap.eraseColor(multiChannel ? SK_ColorBLACK : SkColorSetARGB(0, 255, 255, 255));
+
+    // a8 输出时距离写入唯一的通道
+    int bytesPerPixel = bitmap.bytesPerPixel();
+    int alphaOffset = bytesPerPixel == 1 ? 0 : 3;
+
+    // 字符区域互不重叠, 各字符并行计算后直接写入页面
+    async::parallel_for(async::irange((size_t)0, page.glyphs.size()), [&](size_t index) {
+        auto& glyphInfo = page.glyphs[index];
+        SkIRect rect = SkIRect::MakeXYWH(glyphInfo.x, glyphInfo.y, glyphInfo.width, glyphInfo.height);
+        if (!rect.intersect(SkIRect::MakeWH(page.width, page.height)))
+            return;
+
+        if (multiChannel)
+        {
+            // 由字符轮廓直接计算, 不需要放大光栅化
+            SkPath path;
+            m_pathCache.fill(glyphInfo.font, glyphInfo.glyph_id)->offset(glyphInfo.draw_x - rect.left(), glyphInfo.draw_y - rect.top(), &path);
+
+            std::vector<float> field = multiChannelDistanceField(path, rect.width(), rect.height());
+            correctDistanceFieldErrors(field, rect.width(), rect.height());
+
+            for (int y = 0; y < rect.height(); ++y)
+            {
+                uint8_t* dst = (uint8_t*)bitmap.getAddr(rect.left(), rect.top() + y);
+                const float* src = &field[(size_t)y * rect.width() * 3];
+                for (int x = 0; x < rect.width(); ++x)
+                {
+                    dst[x * 4 + 0] = encodeDistance(src[x * 3 + 0], spread);
+                    dst[x * 4 + 1] = encodeDistance(src[x * 3 + 1], spread);
+                    dst[x * 4 + 2] = encodeDistance(src[x * 3 + 2], spread);
+                }
+            }
+            return;
+        }
+
+        // 放大 scale 倍光栅化字符覆盖率
+        int width = rect.width() * scale;
+        int height = rect.height() * scale;
+        SkBitmap mask;
+        mask.allocPixels(SkImageInfo::MakeA8(width, height));
+        mask.eraseColor(SK_ColorTRANSPARENT);
+
+        SkCanvas canvas(mask);
+        canvas.scale((SkScalar)scale, (SkScalar)scale);
+        canvas.translate(glyphInfo.draw_x - rect.left(), glyphInfo.draw_y - rect.top());
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        canvas.drawPath(*m_pathCache.fill(glyphInfo.font, glyphInfo.glyph_id), paint);
+
+        std::vector<float> field = signedDistanceField(mask.pixmap());
+
+        // 缩小到输出大小, 每个输出像素取对应 scale x scale 区域的平均距离
+        float factor = 1.0f / ((float)scale * scale * scale);
+        for (int y = 0; y < rect.height(); ++y)
+        {
+            uint8_t* dst = (uint8_t*)bitmap.getAddr(rect.left(), rect.top() + y);
+            for (int x = 0; x < rect.width(); ++x)
+            {
+                float sum = 0.0f;
+                for (int sy = 0; sy < scale; ++sy)
+                {
+                    const float* src = &field[(size_t)(y * scale + sy) * width + x * scale];
+                    for (int sx = 0; sx < scale; ++sx)
+                        sum += src[sx];
+                }
+                dst[x * bytesPerPixel + alphaOffset] = encodeDistance(sum * factor, spread);
+            }
+        }
+    });
+}
+
+void FntGen::drawGlyphsLayered(const GenerateConfig& config, const FntPage& page, SkBitmap& bitmap)
+{
+    auto& paints = m_renderStyle.paints();
+    bool hasOutline = config.text_style.outline_thickness > 0;
+
+    bitmap.eraseColor(SK_ColorTRANSPARENT);
+
+    // 阴影覆盖率及其偏移、强度
+    struct GlowMask
+    {
+        MaskImage mask;
+        int dx;
+        int dy;
+        int alpha;
+    };
+
+    struct GlyphLayers
+    {
+        MaskImage fill;
+        MaskImage outline;
+        std::vector<GlowMask> glows;
+    };
+
+    // 将蒙版按 op 合并到页面的 channel 通道
+    auto mergeMask = [&](const MaskImage& mask, int dx, int dy, int channel, auto op) {
+        SkPixmap src;
+        if (!mask.image || !mask.image->peekPixels(&src))
+            return;
+
+        SkIRect rect = SkIRect::MakeXYWH(mask.origin.x() + dx, mask.origin.y() + dy, src.width(), src.height());
+        SkIRect clip = rect;
+        if (!clip.intersect(SkIRect::MakeWH(page.width, page.height)))
+            return;
+
+        for (int y = clip.top(); y < clip.bottom(); ++y)
+        {
+            const uint8_t* srcRow = src.addr8(clip.left() - rect.left(), y - rect.top());
+            uint8_t* dst = (uint8_t*)bitmap.getAddr(clip.left(), y) + channel;
+            for (int x = 0; x < clip.width(); ++x)
+                dst[x * 4] = op(dst[x * 4], srcRow[x]);
+        }
+    };
+
+    auto maxOp = [](uint8_t dst, uint8_t src) { return std::max(dst, src); };
+
+    // 分批计算, 限制同时存在的蒙版数量
+    const size_t batchSize = 256;
+    std::vector<GlyphLayers> layers;
+    for (size_t first = 0; first < page.glyphs.size(); first += batchSize)
+    {
+        size_t count = std::min(batchSize, page.glyphs.size() - first);
+        layers.assign(count, GlyphLayers{});
+
+        // 各字符的蒙版互不依赖, 并行光栅化及模糊
+        async::parallel_for(async::irange((size_t)0, count), [&](size_t index) {
+            auto& glyphInfo = page.glyphs[first + index];
+            auto& glyphLayers = layers[index];
+            GlyphMask mask(glyphInfo, paints, m_pathCache);
+
+            glyphLayers.fill = mask.fill();
+            if (hasOutline)
+                glyphLayers.outline = mask.stroke();
+
+            // 阴影强度与彩色输出一致: 颜色透明度的平方, 合并的重复图层按叠加次数映射
+            auto addGlows = [&](const std::vector<ShadowLayer>& shadowLayers) {
+                for (auto& shadowLayer : shadowLayers)
+                {
+                    float alpha = shadowLayer.paint.getAlphaf();
+                    float intensity = 1.0f - std::pow(1.0f - alpha * alpha, (float)std::max(shadowLayer.count, 1));
+                    glyphLayers.glows.push_back({ mask.blurredFill(shadowLayer.config.blur_radius), shadowLayer.config.offsetx, shadowLayer.config.offsety, (int)std::lround(intensity * 255.0f) });
+                }
+            };
+            if (hasOutline)
+                addGlows(paints.outlineShadowLayers);
+            addGlows(paints.textShadowLayers);
+        });
+
+        // 按字符顺序合并, 超出字符区域的阴影与相邻字符的阴影叠加
+        for (auto& glyphLayers : layers)
+        {
+            mergeMask(glyphLayers.fill, 0, 0, 0, maxOp);
+            mergeMask(glyphLayers.outline, 0, 0, 1, maxOp);
+            for (auto& glow : glyphLayers.glows)
+            {
+                int alpha = glow.alpha;
+                mergeMask(glow.mask, glow.dx, glow.dy, 2, [alpha](uint8_t dst, uint8_t src) {
+                    // 图层之间按 SrcOver 叠加覆盖率
+                    int value = (src * alpha + 127) / 255;
+                    return (uint8_t)(dst + value - (dst * value + 127) / 255);
+                });
+            }
+        }
+    }
+
+    // alpha 通道为各图层覆盖率的最大值, 使通常的透明度混合可以预览图集
+    for (int y = 0; y < page.height; ++y)
+    {
+        uint8_t* row = (uint8_t*)bitmap.getAddr(0, y);
+        for (int x = 0; x < page.width; ++x)
+        {
+            uint8_t* pixel = row + x * 4;
+            pixel[3] = std::max({ pixel[0], pixel[1], pixel[2] });
+        }
+    }
+}
+
+void FntGen::drawGlyphs(const GenerateConfig& config, const FntPage& page, SkCanvas* canvas, const SkIRect& bounds)
+{
+    auto& paints = m_renderStyle.paints();
+
+    canvas->clear(paints.backgroundColor);
+
+    if (config.render_engine == "blob")
+    {
+        drawGlyphsBlob(config, page, canvas, bounds);
+        canvas->flush();
+        return;
+    }
+
+    if (config.shadow_mode == "page")
+    {
+        drawGlyphsPageLayers(config, page, canvas, bounds);
+        canvas->flush();
+        return;
+    }
+
+    for (auto& glyphInfo : page.glyphs)
+    {
+        if (!SkIRect::Intersects(bounds, SkIRect::MakeXYWH(glyphInfo.x, glyphInfo.y, glyphInfo.width, glyphInfo.height).makeOutset(paints.overflow, paints.overflow)))
+            continue;
+
+        drawGlyph(config, glyphInfo, canvas, paints);
+
+        if (config.is_draw_debug)
+            drawGlyphDebug(config, glyphInfo, canvas, paints);
+    }
+
+    canvas->flush();
+}
+
+void FntGen::drawGlyphsBlob(const GenerateConfig& config, const FntPage& page, SkCanvas* canvas, const SkIRect& bounds)
+{
+    auto& paints = m_renderStyle.paints();
+
+    std::vector<const GlyphInfo*> glyphs;
+    glyphs.reserve(page.glyphs.size());
+    for (auto& glyphInfo : page.glyphs)
+    {
+        if (SkIRect::Intersects(bounds, SkIRect::MakeXYWH(glyphInfo.x, glyphInfo.y, glyphInfo.width, glyphInfo.height).makeOutset(paints.overflow, paints.overflow)))
+            glyphs.push_back(&glyphInfo);
+    }
+    if (glyphs.empty())
+        return;
+
+    // 连续的相同字体字符合并为一个 run, 字符原点即绘制位置
+    SkTextBlobBuilder builder;
+    for (size_t first = 0; first < glyphs.size();)
+    {
+        size_t last = first + 1;
+        while (last < glyphs.size() && glyphs[last]->font == glyphs[first]->font)
+            ++last;
+
+        auto& run = builder.allocRunPos(glyphs[first]->font, (int)(last - first));
+        for (size_t i = first; i < last; ++i)
+        {
+            run.glyphs[i - first] = glyphs[i]->glyph_id;
+            run.pos[(i - first) * 2 + 0] = glyphs[i]->draw_x;
+            run.pos[(i - first) * 2 + 1] = glyphs[i]->draw_y;
+        }
+        first = last;
+    }
+    sk_sp<SkTextBlob> blob = builder.make();
+    if (!blob)
+        return;
+
+    // 着色器图片的范围: 当前条带(含超出字符区域的部分)
+    SkIRect cullBounds = bounds.makeOutset(paints.overflow, paints.overflow);
+    if (!cullBounds.intersect(SkIRect::MakeWH(page.width, page.height)))
+        return;
+
+    // SkPictureShader 会限制图片面积(超过时降低分辨率), 范围过大时改为逐字符使用各自定位的着色器绘制
+    const int64_t maxPictureShaderArea = 2048 * 2048;
+    bool pictureShader = (int64_t)cullBounds.width() * cullBounds.height() <= maxPictureShaderArea;
+
+    // 绘制带特效着色器的图层
+    // 按字符定位的特效着色器: 每个字符区域填充各自定位的渐变, 录制为条带范围内的图片着色器
+    auto drawEffectLayer = [&](const SkPaint& layerPaint, const EffectShader& effect, bool outline) {
+        SkPaint paint(layerPaint);
+        if (!effect.shader || effect.degenerate)
+        {
+            setPaintShader(paint, effect, 0, 0, 0, 0);
+            canvas->drawTextBlob(blob, 0, 0, paint);
+            return;
+        }
+
+        if (!pictureShader)
+        {
+            // 描边使用缓存的描边轮廓填充
+            paint.setStyle(SkPaint::kFill_Style);
+            for (auto glyphInfo : glyphs)
+            {
+                SkPath path;
+                if (outline)
+                    m_pathCache.stroke(glyphInfo->font, glyphInfo->glyph_id, paints.outlinePaint.getStrokeWidth())->offset(glyphInfo->draw_x, glyphInfo->draw_y, &path);
+                else
+                    m_pathCache.fill(glyphInfo->font, glyphInfo->glyph_id)->offset(glyphInfo->draw_x, glyphInfo->draw_y, &path);
+
+                setPaintShader(paint, effect, glyphInfo->draw_x, glyphInfo->draw_y - glyphInfo->raw_height, (SkScalar)glyphInfo->raw_width, (SkScalar)glyphInfo->raw_height);
+                canvas->drawPath(path, paint);
+            }
+            return;
+        }
+
+        SkPictureRecorder recorder;
+        SkCanvas* recordCanvas = recorder.beginRecording(SkRect::Make(cullBounds));
+        for (auto glyphInfo : glyphs)
+        {
+            SkPaint cellPaint;
+            setPaintShader(cellPaint, effect, glyphInfo->draw_x, glyphInfo->draw_y - glyphInfo->raw_height, (SkScalar)glyphInfo->raw_width, (SkScalar)glyphInfo->raw_height);
+            recordCanvas->drawRect(SkRect::MakeXYWH((SkScalar)glyphInfo->x, (SkScalar)glyphInfo->y, (SkScalar)glyphInfo->width, (SkScalar)glyphInfo->height), cellPaint);
+        }
+        paint.setShader(recorder.finishRecordingAsPicture()->makeShader(SkTileMode::kDecal, SkTileMode::kDecal, SkFilterMode::kNearest, nullptr, nullptr));
+        canvas->drawTextBlob(blob, 0, 0, paint);
+    };
+
+    // 图层顺序与逐字符绘制相同: 描边阴影、描边、文字阴影、文字
+    if (config.text_style.outline_thickness > 0)
+    {
+        for (auto& shadowLayer : paints.outlineShadowLayers)
+            canvas->drawTextBlob(blob, 0, 0, shadowLayer.paint);
+
+        drawEffectLayer(paints.outlinePaint, paints.outlineEffect, true);
+    }
+
+    for (auto& shadowLayer : paints.textShadowLayers)
+        canvas->drawTextBlob(blob, 0, 0, shadowLayer.paint);
+
+    drawEffectLayer(paints.textPaint, paints.textEffect, false);
+
+    // 蒙版特效逐字符计算
+    if (!paints.maskEffects.empty())
+    {
+        for (auto glyphInfo : glyphs)
+        {
+            GlyphMask mask(*glyphInfo, paints, m_pathCache);
+            mask.drawEffects(canvas, paints.maskEffects);
+        }
+    }
+
+    if (config.is_draw_debug)
+    {
+        for (auto glyphInfo : glyphs)
+            drawGlyphDebug(config, *glyphInfo, canvas, paints);
+    }
+}
+
+void FntGen::drawGlyphsPageLayers(const GenerateConfig& config, const FntPage& page, SkCanvas* canvas, const SkIRect& bounds)
+{
+    auto& paints = m_renderStyle.paints();
+    bool hasOutline = config.text_style.outline_thickness > 0;
+    SkScalar strokeWidth = paints.outlinePaint.getStrokeWidth();
+
+    // 与bounds相交的字符轮廓, 平移到绘制位置
+    struct GlyphPaths
+    {
+        const GlyphInfo* glyphInfo;
+        SkPath fill;
+        SkPath stroke;
+    };
+    std::vector<GlyphPaths> glyphs;
+    glyphs.reserve(page.glyphs.size());
+    for (auto& glyphInfo : page.glyphs)
+    {
+        if (!SkIRect::Intersects(bounds, SkIRect::MakeXYWH(glyphInfo.x, glyphInfo.y, glyphInfo.width, glyphInfo.height).makeOutset(paints.overflow, paints.overflow)))
+            continue;
+
+        glyphs.push_back(GlyphPaths{ .glyphInfo = &glyphInfo, .fill = {}, .stroke = {} });
+        auto& paths = glyphs.back();
+        m_pathCache.fill(glyphInfo.font, glyphInfo.glyph_id)->offset(glyphInfo.draw_x, glyphInfo.draw_y, &paths.fill);
+        if (hasOutline && !paints.outlineFromMask())
+            m_pathCache.stroke(glyphInfo.font, glyphInfo.glyph_id, strokeWidth)->offset(glyphInfo.draw_x, glyphInfo.draw_y, &paths.stroke);
+    }
+    if (glyphs.empty())
+        return;
+
+    // 图层包含超出bounds的字符, 模糊结果在条带边界处与整页绘制一致
+    SkRect layerBounds = SkRect::Make(bounds.makeOutset(paints.overflow, paints.overflow));
+
+    // 阴影滤镜及混合模式设置在图层上, 图层内的字符只填充阴影颜色
+    auto drawShadowLayer = [&](const ShadowLayer& shadowLayer) {
+        SkPaint layerPaint;
+        layerPaint.setImageFilter(shadowLayer.paint.refImageFilter());
+        layerPaint.setBlender(shadowLayer.paint.refBlender());
+        canvas->saveLayer(&layerBounds, &layerPaint);
+
+        SkPaint glyphPaint(shadowLayer.paint);
+        glyphPaint.setImageFilter(nullptr);
+        glyphPaint.setBlendMode(SkBlendMode::kSrcOver);
+        for (auto& paths : glyphs)
+            canvas->drawPath(paths.fill, glyphPaint);
+
+        canvas->restore();
+    };
+
+    auto drawOutlines = [&]() {
+        for (auto& paths : glyphs)
+        {
+            auto& glyphInfo = *paths.glyphInfo;
+            SkPaint outlinePaint(paints.outlinePaint);
+            outlinePaint.setStyle(SkPaint::kFill_Style);
+            setPaintShader(outlinePaint, paints.outlineEffect, glyphInfo.draw_x, glyphInfo.draw_y - glyphInfo.raw_height, (SkScalar)glyphInfo.raw_width, (SkScalar)glyphInfo.raw_height);
+            if (paints.outlineFromMask())
+            {
+                GlyphMask mask(glyphInfo, paints, m_pathCache);
+                mask.drawMask(canvas, mask.stroke(), outlinePaint);
+            }
+            else
+            {
+                canvas->drawPath(paths.stroke, outlinePaint);
+            }
+        }
+    };
+
+    // 图层顺序与逐字符绘制相同: 描边阴影、描边、文字阴影、文字、蒙版特效(内部描边在最上层)
+    bool outlineAbove = paints.outlinePosition == OutlinePosition::Inside;
+    if (hasOutline)
+    {
+        for (auto& shadowLayer : paints.outlineShadowLayers)
+            drawShadowLayer(shadowLayer);
+
+        if (!outlineAbove)
+            drawOutlines();
+    }
+
+    for (auto& shadowLayer : paints.textShadowLayers)
+        drawShadowLayer(shadowLayer);
+
+    for (auto& paths : glyphs)
+    {
+        auto& glyphInfo = *paths.glyphInfo;
+        SkPaint textPaint(paints.textPaint);
+        setPaintShader(textPaint, paints.textEffect, glyphInfo.draw_x, glyphInfo.draw_y - glyphInfo.raw_height, (SkScalar)glyphInfo.raw_width, (SkScalar)glyphInfo.raw_height);
+        canvas->drawPath(paths.fill, textPaint);
+    }
+
+    if (!paints.maskEffects.empty())
+    {
+        for (auto& paths : glyphs)
+        {
+            GlyphMask mask(*paths.glyphInfo, paints, m_pathCache);
+            mask.drawEffects(canvas, paints.maskEffects);
+        }
+    }
+
+    if (hasOutline && outlineAbove)
+        drawOutlines();
+
+    if (config.is_draw_debug)
+    {
+        for (auto& paths : glyphs)
+            drawGlyphDebug(config, *paths.glyphInfo, canvas, paints);
+    }
+}
+
+void FntGen::drawGlyph(const GenerateConfig& config, const GlyphInfo& glyphInfo, SkCanvas* canvas, const GlyphPaints& paints)
+{
+    SkScalar drawx = glyphInfo.draw_x;
+    SkScalar drawy = glyphInfo.draw_y;
+
+    SkScalar w = (SkScalar)glyphInfo.raw_width;
+    SkScalar h = (SkScalar)glyphInfo.raw_height;
+
+    bool useMask = paints.useMask;
+
+    bool hasOutline = config.text_style.outline_thickness > 0;
+
+    // 字符覆盖率蒙版, 各图层共用
+    GlyphMask mask(glyphInfo, paints, m_pathCache);
+
+    // 滤镜方式使用缓存的轮廓绘制, 轮廓平移到绘制位置(着色器使用页面坐标, 不能平移画布)
+    SkPath fillPath;
+    SkPath strokePath;
+    if (!useMask)
+    {
+        m_pathCache.fill(glyphInfo.font, glyphInfo.glyph_id)->offset(drawx, drawy, &fillPath);
+        if (hasOutline && !paints.outlineFromMask())
+            m_pathCache.stroke(glyphInfo.font, glyphInfo.glyph_id, paints.outlinePaint.getStrokeWidth())->offset(drawx, drawy, &strokePath);
+    }
+
+    // 内部描边绘制在文字之上
+    bool outlineAbove = paints.outlinePosition == OutlinePosition::Inside;
+    auto drawOutline = [&]() {
+        // 描边轮廓已预先生成, 使用填充方式绘制
+        SkPaint outlinePaint(paints.outlinePaint);
+        outlinePaint.setStyle(SkPaint::kFill_Style);
+        setPaintShader(outlinePaint, paints.outlineEffect, drawx, drawy - h, w, h);
+        // 距离变换生成及非居中位置的描边只有覆盖率蒙版
+        if (useMask || paints.outlineFromMask())
+            mask.drawMask(canvas, mask.stroke(), outlinePaint);
+        else
+            canvas->drawPath(strokePath, outlinePaint);
+    };
+
+    // 描边绘制
+    if (hasOutline)
+    {
+        // 描边阴影
+        for (auto& shadowLayer : paints.outlineShadowLayers)
+        {
+            //setPaintShader(shadowLayer.paint, shadowLayer.config.effect, drawx, drawy - h, w, h);
+            if (useMask)
+                mask.drawShadow(canvas, shadowLayer);
+            else
+                canvas->drawPath(fillPath, shadowLayer.paint);
+        }
+
+        if (!outlineAbove)
+            drawOutline();
+    }
+
+    // 文字阴影
+    for (auto& shadowLayer : paints.textShadowLayers)
+    {
+        //setPaintShader(shadowLayer.paint, shadowLayer.config.effect, drawx, drawy - h, w, h);
+        if (useMask)
+            mask.drawShadow(canvas, shadowLayer);
+        else
+            canvas->drawPath(fillPath, shadowLayer.paint);
+    }
+
+    // 文字绘制
+    SkPaint textPaint(paints.textPaint);
+    setPaintShader(textPaint, paints.textEffect, drawx, drawy - h, w, h);
+    if (useMask)
+        mask.drawMask(canvas, mask.fill(), textPaint);
+    else
+        canvas->drawPath(fillPath, textPaint);
+
+    // 蒙版特效
+    if (!paints.maskEffects.empty())
+        mask.drawEffects(canvas, paints.maskEffects);
+
+    if (hasOutline && outlineAbove)
+        drawOutline();
+}
+
+void FntGen::drawGlyphDebug(const GenerateConfig& config, const GlyphInfo& glyphInfo, SkCanvas* canvas, const GlyphPaints& paints)
+{
+    // 调试画笔
+    SkPaint debugPaint;
+    debugPaint.setAntiAlias(true);                // 开启抗锯齿
+    debugPaint.setStyle(SkPaint::kStroke_Style);  // 设置为描边模式
+    debugPaint.setStrokeWidth(1);                 // 设置描边宽度
+
+    // 字符增加的宽高
+    int glyhMargin = config.text_style.outline_thickness;
+
+    // 字符宽高（字符宽高+描边大小）
+    int glyphWidth = glyphInfo.raw_width + glyhMargin * 2;
+    int glyphHeight = glyphInfo.raw_height + glyhMargin * 2;
+
+    // 绘制字符全部区域
+    if (config.is_debug_draw_glyph_all_area)
+    {
+        if (config.glyph_padding_left != 0 || config.glyph_padding_right != 0 || config.glyph_padding_up != 0 || config.glyph_padding_down != 0)
+        {
+            // 绘制字符不带描边区域
+            SkRect rect = SkRect::MakeXYWH(glyphInfo.x, glyphInfo.y, glyphInfo.width, glyphInfo.height);
+            debugPaint.setColor(paints.debugAllAreaColor);
+            canvas->drawRect(rect, debugPaint);
+        }
+    }
+
+    if (config.is_debug_draw_glyph_real_area)
+    {
+        // 绘制字符实际区域
+        SkRect rect = SkRect::MakeXYWH(glyphInfo.x + config.glyph_padding_left, glyphInfo.y + config.glyph_padding_up, glyphWidth + glyphInfo.padding_left + glyphInfo.padding_right, glyphHeight + glyphInfo.padding_up + glyphInfo.padding_down);
+        debugPaint.setColor(paints.debugRealAreaColor);
+        canvas->drawRect(rect, debugPaint);
+    }
+
+    // 绘制字符+描边区域
+    if (config.is_debug_draw_glyph_outline_thickness_area && config.text_style.outline_thickness > 0)
+    {
+        SkRect rect = SkRect::MakeXYWH(glyphInfo.x + config.glyph_padding_left + glyphInfo.padding_left, glyphInfo.y + config.glyph_padding_up + glyphInfo.padding_up, glyphWidth, glyphHeight);
+        debugPaint.setColor(paints.debugOutlineThicknessAreaColor);
+        canvas->drawRect(rect, debugPaint);
+    }
+
+    if (config.is_debug_draw_glyph_raw_area)
+    {
+        // 绘制字符不带描边区域
+        SkRect rect = SkRect::MakeXYWH(glyphInfo.x + config.glyph_padding_left + glyphInfo.padding_left + glyhMargin, glyphInfo.y + config.glyph_padding_up + glyphInfo.padding_up + glyhMargin, glyphInfo.raw_width, glyphInfo.raw_height);
+        debugPaint.setColor(paints.debugRawAreaColor);
+        canvas->drawRect(rect, debugPaint);
+    }
+}
+
 bool FntGen::saveFont(const GenerateConfig& config)
 {
     if (m_isEditorMode)
@@ -626,13 +1997,47 @@ bool FntGen::saveFont(const GenerateConfig& config)
 
     int outWidth = 0;
     int outHeight = 0;
-    int numPages = m_fntInfo.pages.size();
-    int fourChnlPacked = 0;
+    size_t numPages = m_fntInfo.pages.size();
+    // 通道打包时多个页面共用一张纹理
+    if (config.channel_packing && !m_fntInfo.pages.empty())
+        numPages = (size_t)m_fntInfo.pages.back().texture + 1;
+    int fourChnlPacked = config.channel_packing ? 1 : 0;
     int alphaChnl = 1;
     int redChnl = 0;
     int greenChnl = 0;
     int blueChnl = 0;
 
+    // 通道内容: 0 字符, 1 描边, 2 字符及描边, 4 全部为1
+    if (config.channel_packing)
+    {
+        // 每个通道包含不同的字符
+        alphaChnl = redChnl = greenChnl = blueChnl = isDistanceFieldMode(config) || config.text_style.outline_thickness <= 0 ? 0 : 2;
+    }
+    else if (config.output_format == "a8")
+    {
+        // 不透明灰度图片, 字符在 RGB(亮度)中, 透明度恒为1, 运行时以亮度作为透明度
+        alphaChnl = 4;
+        redChnl = greenChnl = blueChnl = isDistanceFieldMode(config) || config.text_style.outline_thickness <= 0 ? 0 : 2;
+    }
+    else if (config.output_format == "layers")
+    {
+        // R 文字, G 描边, B 外发光(标记为 3, 标准加载器不会当作字形), A 全部
+        alphaChnl = 2;
+        redChnl = 0;
+        greenChnl = 1;
+        blueChnl = 3;
+    }
+    else if (config.render_mode == "sdf")
+    {
+        alphaChnl = 0;
+        redChnl = greenChnl = blueChnl = 4;
+    }
+    else if (config.render_mode == "msdf")
+    {
+        alphaChnl = 4;
+        redChnl = greenChnl = blueChnl = 0;
+    }
+
     for (auto& page : m_fntInfo.pages)
     {
         if (outWidth < page.width)
@@ -648,16 +2053,47 @@ bool FntGen::saveFont(const GenerateConfig& config)
 
     fprintf(f, "info face=\"arial\" size=%d bold=%d italic=%d charset=\"%s\" unicode=%d stretchH=%d smooth=%d aa=%d padding=%d,%d,%d,%d spacing=%d,%d outline=%d\r\n", m_fntInfo.fontSize, m_fntInfo.isBold, m_fntInfo.isItalic, m_fntInfo.useUnicode ? "" : "ANSI", m_fntInfo.useUnicode, m_fntInfo.scaleH, m_fntInfo.useSmoothing, m_fntInfo.aa, m_fntInfo.paddingUp, m_fntInfo.paddingRight, m_fntInfo.paddingDown, m_fntInfo.paddingLeft, m_fntInfo.spacingHoriz, m_fntInfo.spacingVert, m_fntInfo.outlineThickness);
     fprintf(f, "common lineHeight=%d base=%d scaleW=%d scaleH=%d pages=%d packed=%d alphaChnl=%d redChnl=%d greenChnl=%d blueChnl=%d\r\n", m_fntInfo.commonLineHeight, m_fntInfo.base, outWidth, outHeight, int(numPages), fourChnlPacked, alphaChnl, redChnl, greenChnl, blueChnl);
+    if (isDistanceFieldMode(config))
+    {
+        // 距离场类型及范围(像素), 与 msdf-bmfont 格式一致
+        fprintf(f, "distanceField fieldType=%s distanceRange=%d\r\n", config.render_mode.c_str(), config.sdf_spread * 2);
+    }
+    else if (config.output_format == "layers")
+    {
+        // 各通道对应的图层(扩展行, 说明见 readme.md)
+        fprintf(f, "layers red=fill green=outline blue=glow alpha=all\r\n");
+    }
 
     for (size_t n = 0; n < numPages; n++)
     {
-        auto&& page = m_fntInfo.pages[n];
-        fprintf(f, "page id=%d file=\"%s\"\r\n", (int)n, getBasename(page.fileName).c_str());
+        // 纹理包含的页面
+        std::vector<const FntPage*> texturePages;
+        if (config.channel_packing)
+        {
+            for (auto& page : m_fntInfo.pages)
+            {
+                if (page.texture == (int)n)
+                    texturePages.push_back(&page);
+            }
+        }
+        else
+        {
+            texturePages.push_back(&m_fntInfo.pages[n]);
+        }
+
+        size_t charCount = 0;
+        for (auto page : texturePages)
+            charCount += page->glyphs.size();
 
-        fprintf(f, "chars count=%d\r\n", (int)page.glyphs.size());
-        for (auto&& glyphInfo : page.glyphs)
+        fprintf(f, "page id=%d file=\"%s\"\r\n", (int)n, getBasename(texturePages[0]->fileName).c_str());
+
+        fprintf(f, "chars count=%d\r\n", (int)charCount);
+        for (auto page : texturePages)
         {
-            fprintf(f, "char id=%lld   x=%d     y=%d     width=%d    height=%d    xoffset=%d     yoffset=%d     xadvance=%d    page=%d  chnl=%d\r\n", (long long)glyphInfo.codepoint, glyphInfo.x, glyphInfo.y, glyphInfo.width, glyphInfo.height, glyphInfo.xoffset, glyphInfo.yoffset, glyphInfo.xadvance, glyphInfo.page, glyphInfo.chnl);
+            for (auto&& glyphInfo : page->glyphs)
+            {
+                fprintf(f, "char id=%lld   x=%d     y=%d     width=%d    height=%d    xoffset=%d     yoffset=%d     xadvance=%d    page=%d  chnl=%d\r\n", (long long)glyphInfo.codepoint, glyphInfo.x, glyphInfo.y, glyphInfo.width, glyphInfo.height, glyphInfo.xoffset, glyphInfo.yoffset, glyphInfo.xadvance, glyphInfo.page, glyphInfo.chnl);
+            }
         }
     }
 
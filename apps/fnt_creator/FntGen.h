@@ -1,6 +1,13 @@
 ﻿#pragma once
 
 #include "Common.h"
+#include "Utils.h"
+#include "RenderStyle.h"
+#include "GlyphPathCache.h"
+
+#include <thread>
+
+typedef struct GLFWwindow GLFWwindow;
 
 struct PageRenderOpenglData
 {
@@ -20,6 +27,10 @@ public:
 
 	bool run(const GenerateConfig& config);
 
+	// 只进行字体匹配和排版, 不渲染图片, 输出各页面尺寸及显存占用等信息
+	// reportFile为空时输出到控制台, 否则保存为json文件
+	bool plan(const GenerateConfig& config, const std::string& reportFile);
+
 	void setEditorMode(bool value) { m_isEditorMode = value; }
 
 	void setEditorShowPageIndex(int value) { m_editorShowPageIndex = value; }
@@ -34,21 +45,93 @@ public:
 		m_pageRenderOpenglData.height = 0;
 	}
 
-	bool supportGPU() { return m_context != nullptr; }
+	// 首次调用时才初始化opengl及skia GPU上下文
+	bool supportGPU();
+
+	// 按 run 实际使用的配置(resolveRenderConfig 之后)判断是否使用GPU渲染
+	// 使用GPU渲染时 run 必须在创建 FntGen 的线程(持有opengl上下文)中调用
+	bool isGPURendering(const GenerateConfig& config);
 
 private:
 
+	// 已解析的配置是否使用GPU渲染
+	bool useGPURendering(const GenerateConfig& config);
+
+	// 按输出内容调整配置(如距离场模式预留字符四周距离)
+	GenerateConfig resolveRenderConfig(const GenerateConfig& config);
+
+	bool generate(const GenerateConfig& config);
+
+	bool planLayout(const GenerateConfig& config, const std::string& reportFile);
+
+	void initGPU();
+
+	void initFntInfo(const GenerateConfig& config);
+
+	GenerateConfig fitFontSize(const GenerateConfig& config);
+
+	bool isPagesFit(const GenerateConfig& config, const std::vector<FntPage>& matchedPages, const std::unordered_map<char32_t, double>& frequency);
+
 	void matchFont(const GenerateConfig& config);
 
+	void orderPagesByFrequency(const GenerateConfig& config);
+	// 使用已读取的使用频率表, 自动适配时只读取一次频率文件
+	void orderPagesByFrequency(const GenerateConfig& config, const std::unordered_map<char32_t, double>& frequency);
+
+	void splitPages(const GenerateConfig& config);
+
+	void layout(const GenerateConfig& config);
+
 	bool draw(const GenerateConfig& config);
 
 	void initPageData(const GenerateConfig& config, FntPage& page, int pageIndex);
 
-	bool drawPage(const GenerateConfig& config, FntPage& page);
+	void initPageFileName(FntPage& page, int pageIndex);
+
+	std::string getPageFileName(int pageIndex, int pageCount);
+
+	// 通道打包: 每4个页面共用一张纹理, 设置页面所在纹理、通道及字符的 page、chnl
+	void packChannels();
+
+	void initGlyphPadding(FntPage& page);
+
+	// useGPU 由调用方在opengl上下文所属线程判断, 并行绘制时为 false
+	bool drawPage(const GenerateConfig& config, FntPage& page, bool useGPU);
+
+	// CPU绘制页面到位图
+	void drawPageBitmap(const GenerateConfig& config, const FntPage& page, SkBitmap& bitmap);
+
+	// 通道打包时绘制并保存纹理
+	bool drawPackedTextures(const GenerateConfig& config);
 
 	bool saveBitmapToFile(const std::string& filename, SkBitmap& bitmap);
 
-	void drawGlyphs(const GenerateConfig& config, FntPage& page, SkCanvas* canvas);
+	void layoutGlyphs(const GenerateConfig& config, FntPage& page);
+
+	// 绘制与bounds相交的字符
+	void drawGlyphs(const GenerateConfig& config, const FntPage& page, SkCanvas* canvas, const SkIRect& bounds);
+
+	// 每个图层将与bounds相交的字符合并为一个 SkTextBlob 绘制
+	void drawGlyphsBlob(const GenerateConfig& config, const FntPage& page, SkCanvas* canvas, const SkIRect& bounds);
+
+	// 逐图层绘制与bounds相交的字符, 阴影图层使用带滤镜的 saveLayer, 模糊在整个图层上只计算一次
+	void drawGlyphsPageLayers(const GenerateConfig& config, const FntPage& page, SkCanvas* canvas, const SkIRect& bounds);
+
+	// CPU多线程绘制, 页面按水平条带拆分, 每个条带使用独立的 SkCanvas 写入同一块像素内存
+	void drawGlyphsBanded(const GenerateConfig& config, const FntPage& page, SkBitmap& bitmap);
+
+	// 每个字符并行计算有符号距离场, 写入页面alpha通道
+	void drawGlyphsDistanceField(const GenerateConfig& config, const FntPage& page, SkBitmap& bitmap);
+
+	// 分层通道: 文字、描边、阴影覆盖率分别写入页面的R、G、B通道
+	void drawGlyphsLayered(const GenerateConfig& config, const FntPage& page, SkBitmap& bitmap);
+
+	// 每个字符并行绘制到独立的精灵图, 再按顺序合成到页面
+	void drawGlyphsSprite(const GenerateConfig& config, const FntPage& page, SkCanvas* canvas);
+
+	void drawGlyph(const GenerateConfig& config, const GlyphInfo& glyphInfo, SkCanvas* canvas, const GlyphPaints& paints);
+
+	void drawGlyphDebug(const GenerateConfig& config, const GlyphInfo& glyphInfo, SkCanvas* canvas, const GlyphPaints& paints);
 
 	bool saveFont(const GenerateConfig& config);
 
@@ -60,6 +143,16 @@ private:
 	std::string m_outFileName;
 	int m_maxOffsetY;
 	FntInfo m_fntInfo;
-
+	std::vector<char32_t> m_missingCodepoints;
+	// 编译后的渲染样式, 编辑器中多次渲染时复用
+	RenderStyle m_renderStyle;
+	// 字符轮廓缓存, 各图层及线程共享
+	GlyphPathCache m_pathCache;
+
+	bool m_gpuInitialized;
+	// 命令行模式下创建的隐藏窗口
+	GLFWwindow* m_window;
+	// 创建 FntGen 的线程, opengl上下文只能在该线程中初始化及使用
+	std::thread::id m_ownerThread;
 	sk_sp<GrDirectContext> m_context;
 };
@@ -0,0 +1,412 @@
+﻿#include "GlyphMask.h"
+#include "DistanceField.h"
+#include "include/effects/SkImageFilters.h"
+
+// 距离变换生成描边时的光栅化倍数, 每个输出像素由 scale x scale 个采样点的覆盖率平均得到
+static const int OUTLINE_EDT_SCALE = 4;
+
+GlyphMask::GlyphMask(const GlyphInfo& glyphInfo, const GlyphPaints& paints, GlyphPathCache& pathCache)
+    : m_glyphInfo(glyphInfo)
+    , m_strokeWidth(paints.outlinePaint.getStrokeWidth())
+    , m_blur(paints.blur)
+    , m_outlineEdt(paints.outlineEdt)
+    , m_outlinePosition(paints.outlinePosition)
+    , m_pathCache(pathCache)
+{
+    m_fill.origin = SkIPoint::Make(0, 0);
+    m_stroke.origin = SkIPoint::Make(0, 0);
+}
+
+const MaskImage& GlyphMask::fill()
+{
+    if (!m_fill.image)
+        m_fill = rasterize(*m_pathCache.fill(m_glyphInfo.font, m_glyphInfo.glyph_id));
+    return m_fill;
+}
+
+const MaskImage& GlyphMask::stroke()
+{
+    if (!m_stroke.image)
+    {
+        MaskImage stroke;
+        if (m_outlineEdt)
+            stroke = rasterizeOutline();
+        else
+            stroke = rasterize(*m_pathCache.stroke(m_glyphInfo.font, m_glyphInfo.glyph_id, m_strokeWidth));
+
+        if (m_outlinePosition != OutlinePosition::Center)
+            stroke = clipToFill(stroke, m_outlinePosition == OutlinePosition::Inside);
+        m_stroke = stroke;
+    }
+    return m_stroke;
+}
+
+const MaskImage& GlyphMask::blurredFill(SkScalar sigma)
+{
+    auto& src = fill();
+    if (sigma <= 0.0f || !src.image)
+        return src;
+
+    for (auto& it : m_blurredFills)
+    {
+        if (it.first == sigma)
+            return it.second;
+    }
+
+    // 盒式模糊无法近似的较小 sigma 使用高斯模糊
+    bool box = m_blur.box && boxBlurSupported(sigma);
+
+    // 模糊范围为3倍sigma
+    int pad = box ? maskBlurPadding(sigma) : (int)std::ceil(sigma * 3.0f);
+
+    SkBitmap bitmap;
+    SkPixmap srcPixels;
+    if (box && src.image->peekPixels(&srcPixels))
+    {
+        // 模糊半径较大时降采样模糊
+        blurMask(srcPixels, sigma, &bitmap, maskBlurScale(sigma, m_blur.maxError));
+    }
+    else
+    {
+        bitmap.allocPixels(SkImageInfo::MakeA8(src.image->width() + pad * 2, src.image->height() + pad * 2));
+        bitmap.eraseColor(SK_ColorTRANSPARENT);
+
+        SkCanvas canvas(bitmap);
+        SkPaint paint;
+        paint.setImageFilter(SkImageFilters::Blur(sigma, sigma, nullptr));
+        canvas.drawImage(src.image, (SkScalar)pad, (SkScalar)pad, SkSamplingOptions(), &paint);
+    }
+    bitmap.setImmutable();
+
+    MaskImage mask;
+    mask.image = bitmap.asImage();
+    mask.origin = SkIPoint::Make(src.origin.x() - pad, src.origin.y() - pad);
+    m_blurredFills.emplace_back(sigma, mask);
+    return m_blurredFills.back().second;
+}
+
+void GlyphMask::drawMask(SkCanvas* canvas, const MaskImage& mask, const SkPaint& paint, SkScalar dx, SkScalar dy)
+{
+    if (!mask.image)
+        return;
+
+    SkPaint maskPaint(paint);
+    maskPaint.setStyle(SkPaint::kFill_Style);
+    canvas->drawImage(mask.image, mask.origin.x() + dx, mask.origin.y() + dy, SkSamplingOptions(), &maskPaint);
+}
+
+void GlyphMask::drawShadow(SkCanvas* canvas, const ShadowLayer& layer)
+{
+    auto& fillMask = fill();
+    if (!fillMask.image)
+        return;
+
+    auto& shadow = layer.config;
+    auto& blurredMask = blurredFill(shadow.blur_radius);
+
+    // 文字本身
+    SkPaint glyphPaint(layer.paint);
+    glyphPaint.setImageFilter(nullptr);
+
+    // DropShadow 以 SrcIn 的方式将阴影颜色作用于已着色的文字, 因此阴影透明度为颜色透明度的平方
+    SkPaint shadowPaint(glyphPaint);
+    U8CPU alpha = glyphPaint.getAlpha();
+    shadowPaint.setAlpha((alpha * alpha + 127) / 255);
+
+    // 先合成阴影和文字, 再以图层的方式混合到页面
+    // 非 SrcOver 混合需要作用于合成结果, 合并的重复图层需要对合成结果做透明度映射
+    bool useLayer = !glyphPaint.isSrcOver() || layer.count > 1;
+    if (useLayer)
+    {
+        SkRect bounds = SkRect::Make(SkIRect::MakeXYWH(fillMask.origin.x(), fillMask.origin.y(), fillMask.image->width(), fillMask.image->height()));
+        bounds.join(SkRect::Make(SkIRect::MakeXYWH(blurredMask.origin.x() + shadow.offsetx, blurredMask.origin.y() + shadow.offsety, blurredMask.image->width(), blurredMask.image->height())));
+
+        SkPaint layerPaint;
+        layerPaint.setBlender(glyphPaint.refBlender());
+        if (layer.count > 1)
+            layerPaint.setColorFilter(makeRepeatAlphaFilter(layer.count));
+        canvas->saveLayer(&bounds, &layerPaint);
+
+        glyphPaint.setBlendMode(SkBlendMode::kSrcOver);
+        shadowPaint.setBlendMode(SkBlendMode::kSrcOver);
+    }
+
+    drawMask(canvas, blurredMask, shadowPaint, (SkScalar)shadow.offsetx, (SkScalar)shadow.offsety);
+    drawMask(canvas, fillMask, glyphPaint);
+
+    if (useLayer)
+        canvas->restore();
+}
+
+MaskImage GlyphMask::rasterize(const SkPath& path)
+{
+    MaskImage mask;
+    mask.origin = SkIPoint::Make(0, 0);
+
+    SkRect bounds = path.getBounds();
+    bounds.offset(m_glyphInfo.draw_x, m_glyphInfo.draw_y);
+
+    // 为抗锯齿预留1像素
+    SkIRect maskBounds = bounds.roundOut().makeOutset(1, 1);
+    if (bounds.isEmpty() || maskBounds.isEmpty())
+        return mask;
+
+    SkBitmap bitmap;
+    bitmap.allocPixels(SkImageInfo::MakeA8(maskBounds.width(), maskBounds.height()));
+    bitmap.eraseColor(SK_ColorTRANSPARENT);
+
+    // 整数平移, 光栅化结果与直接绘制在页面上一致
+    SkCanvas canvas(bitmap);
+    canvas.translate(m_glyphInfo.draw_x - maskBounds.left(), m_glyphInfo.draw_y - maskBounds.top());
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    canvas.drawPath(path, paint);
+    bitmap.setImmutable();
+
+    mask.image = bitmap.asImage();
+    mask.origin = maskBounds.topLeft();
+    return mask;
+}
+
+MaskImage GlyphMask::rasterizeOutline()
+{
+    MaskImage mask;
+    mask.origin = SkIPoint::Make(0, 0);
+
+    const SkPath& path = *m_pathCache.fill(m_glyphInfo.font, m_glyphInfo.glyph_id);
+    SkRect bounds = path.getBounds();
+    bounds.offset(m_glyphInfo.draw_x, m_glyphInfo.draw_y);
+
+    // 描边向外扩展半个描边宽度, 另预留1像素抗锯齿
+    SkScalar halfWidth = m_strokeWidth * 0.5f;
+    int outset = (int)std::ceil(halfWidth) + 1;
+    SkIRect maskBounds = bounds.roundOut().makeOutset(outset, outset);
+    if (bounds.isEmpty() || maskBounds.isEmpty())
+        return mask;
+
+    // 放大光栅化字符填充
+    const int scale = OUTLINE_EDT_SCALE;
+    SkBitmap fill;
+    fill.allocPixels(SkImageInfo::MakeA8(maskBounds.width() * scale, maskBounds.height() * scale));
+    fill.eraseColor(SK_ColorTRANSPARENT);
+
+    SkCanvas canvas(fill);
+    canvas.scale((SkScalar)scale, (SkScalar)scale);
+    canvas.translate(m_glyphInfo.draw_x - maskBounds.left(), m_glyphInfo.draw_y - maskBounds.top());
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    canvas.drawPath(path, paint);
+
+    // 采样点到轮廓的距离(采样像素), 距离不超过半个描边宽度的采样点位于描边内
+    std::vector<float> field = signedDistanceField(fill.pixmap());
+    float limit = halfWidth * scale;
+
+    SkBitmap bitmap;
+    bitmap.allocPixels(SkImageInfo::MakeA8(maskBounds.width(), maskBounds.height()));
+    int fieldWidth = fill.width();
+    int samples = scale * scale;
+    for (int y = 0; y < maskBounds.height(); ++y)
+    {
+        uint8_t* dst = bitmap.getAddr8(0, y);
+        for (int x = 0; x < maskBounds.width(); ++x)
+        {
+            int count = 0;
+            for (int sy = 0; sy < scale; ++sy)
+            {
+                const float* src = &field[(size_t)(y * scale + sy) * fieldWidth + x * scale];
+                for (int sx = 0; sx < scale; ++sx)
+                    count += std::abs(src[sx]) <= limit ? 1 : 0;
+            }
+            dst[x] = (uint8_t)((count * 255 + samples / 2) / samples);
+        }
+    }
+    bitmap.setImmutable();
+
+    mask.image = bitmap.asImage();
+    mask.origin = maskBounds.topLeft();
+    return mask;
+}
+
+MaskImage GlyphMask::clipToFill(const MaskImage& mask, bool inside)
+{
+    SkPixmap src, fillPixels;
+    auto& fillMask = fill();
+    if (!mask.image || !mask.image->peekPixels(&src))
+        return mask;
+
+    bool hasFill = fillMask.image && fillMask.image->peekPixels(&fillPixels);
+
+    SkBitmap bitmap;
+    bitmap.allocPixels(SkImageInfo::MakeA8(src.width(), src.height()));
+    for (int y = 0; y < src.height(); ++y)
+    {
+        const uint8_t* srcRow = src.addr8(0, y);
+        uint8_t* dst = bitmap.getAddr8(0, y);
+        int fy = mask.origin.y() + y - fillMask.origin.y();
+        for (int x = 0; x < src.width(); ++x)
+        {
+            // 填充覆盖率, 超出填充蒙版的部分为0
+            int fx = mask.origin.x() + x - fillMask.origin.x();
+            int coverage = 0;
+            if (hasFill && fx >= 0 && fy >= 0 && fx < fillPixels.width() && fy < fillPixels.height())
+                coverage = *fillPixels.addr8(fx, fy);
+            if (!inside)
+                coverage = 255 - coverage;
+            dst[x] = (uint8_t)((srcRow[x] * coverage + 127) / 255);
+        }
+    }
+    bitmap.setImmutable();
+
+    MaskImage result;
+    result.image = bitmap.asImage();
+    result.origin = mask.origin;
+    return result;
+}
+
+std::vector<float> GlyphMask::bevelShading(const MaskEffect& config)
+{
+    SkPixmap fillPixels;
+    fill().image->peekPixels(&fillPixels);
+    int width = fillPixels.width();
+    int height = fillPixels.height();
+
+    // 高度为到轮廓的距离, 超过斜面宽度的部分为平面
+    float size = std::max(config.size, 1.0f);
+    std::vector<float> heights = signedDistanceField(fillPixels);
+    for (auto& h : heights)
+        h = std::min(std::max(h / size, 0.0f), 1.0f);
+
+    // 光源方向(图片坐标y轴向下)
+    float radians = config.angle * 3.14159265f / 180.0f;
+    float lx = std::cos(radians);
+    float ly = -std::sin(radians);
+
+    // Sobel 梯度, 斜坡上的梯度归一化为1, 朝向光源的斜面为正
+    auto at = [&](int x, int y) {
+        x = std::min(std::max(x, 0), width - 1);
+        y = std::min(std::max(y, 0), height - 1);
+        return heights[(size_t)y * width + x];
+    };
+    float factor = size / 8.0f;
+    std::vector<float> shading((size_t)width * height);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            float gx = (at(x + 1, y - 1) + 2.0f * at(x + 1, y) + at(x + 1, y + 1)) - (at(x - 1, y - 1) + 2.0f * at(x - 1, y) + at(x - 1, y + 1));
+            float gy = (at(x - 1, y + 1) + 2.0f * at(x, y + 1) + at(x + 1, y + 1)) - (at(x - 1, y - 1) + 2.0f * at(x, y - 1) + at(x + 1, y - 1));
+            float shade = -(gx * lx + gy * ly) * factor;
+            shading[(size_t)y * width + x] = std::min(std::max(shade, -1.0f), 1.0f);
+        }
+    }
+    return shading;
+}
+
+MaskImage GlyphMask::effects(const std::vector<MaskEffectLayer>& layers)
+{
+    MaskImage result;
+    result.origin = SkIPoint::Make(0, 0);
+
+    // 没有特效时不光栅化文字蒙版
+    if (layers.empty())
+        return result;
+
+    auto& fillMask = fill();
+    SkPixmap fillPixels;
+    if (!fillMask.image || !fillMask.image->peekPixels(&fillPixels))
+        return result;
+
+    int width = fillPixels.width();
+    int height = fillPixels.height();
+    size_t count = (size_t)width * height;
+
+    // 预乘颜色累加缓冲区, 按通道分开存放便于逐行连续计算
+    std::vector<float> accum[4];
+    for (auto& channel : accum)
+        channel.assign(count, 0.0f);
+    std::vector<float> alpha(count);
+
+    // 以 SrcOver 方式将透明度为 alpha * color.a 的颜色叠加到累加缓冲区
+    auto blend = [&](SkColor color) {
+        float c[4] = { SkColorGetR(color) / 255.0f, SkColorGetG(color) / 255.0f, SkColorGetB(color) / 255.0f, SkColorGetA(color) / 255.0f };
+        for (int i = 0; i < 4; ++i)
+        {
+            float value = i == 3 ? 1.0f : c[i];
+            float* dst = accum[i].data();
+            const float* a = alpha.data();
+            for (size_t p = 0; p < count; ++p)
+            {
+                float srcA = a[p] * c[3];
+                dst[p] = value * srcA + dst[p] * (1.0f - srcA);
+            }
+        }
+    };
+
+    for (auto& layer : layers)
+    {
+        auto& config = layer.config;
+        if (config.effect_type == "bevel")
+        {
+            std::vector<float> shading = bevelShading(config);
+            for (size_t p = 0; p < count; ++p)
+                alpha[p] = std::max(shading[p], 0.0f);
+            blend(layer.highlightColor);
+            for (size_t p = 0; p < count; ++p)
+                alpha[p] = std::max(-shading[p], 0.0f);
+            blend(layer.shadowColor);
+            continue;
+        }
+
+        // 内阴影及内发光: 文字外部区域(1 - 填充覆盖率)模糊、偏移后的透明度
+        bool shadow = config.effect_type == "inner_shadow";
+        int dx = shadow ? config.offsetx : 0;
+        int dy = shadow ? config.offsety : 0;
+        auto& blurred = blurredFill(std::max(config.blur_radius, 0.0f));
+        SkPixmap blurredPixels;
+        blurred.image->peekPixels(&blurredPixels);
+
+        for (int y = 0; y < height; ++y)
+        {
+            int by = fillMask.origin.y() + y - dy - blurred.origin.y();
+            float* a = &alpha[(size_t)y * width];
+            for (int x = 0; x < width; ++x)
+            {
+                int bx = fillMask.origin.x() + x - dx - blurred.origin.x();
+                float coverage = 0.0f;
+                if (bx >= 0 && by >= 0 && bx < blurredPixels.width() && by < blurredPixels.height())
+                    coverage = *blurredPixels.addr8(bx, by) / 255.0f;
+                a[x] = 1.0f - coverage;
+            }
+        }
+        blend(layer.color);
+    }
+
+    // 限制在文字填充范围内
+    SkBitmap bitmap;
+    bitmap.allocPixels(SkImageInfo::Make(width, height, kRGBA_8888_SkColorType, kPremul_SkAlphaType));
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* coverage = fillPixels.addr8(0, y);
+        uint8_t* dst = (uint8_t*)bitmap.getAddr(0, y);
+        for (int x = 0; x < width; ++x)
+        {
+            size_t p = (size_t)y * width + x;
+            float scale = (float)coverage[x];
+            for (int i = 0; i < 4; ++i)
+                dst[x * 4 + i] = (uint8_t)std::min(accum[i][p] * scale + 0.5f, 255.0f);
+        }
+    }
+    bitmap.setImmutable();
+
+    result.image = bitmap.asImage();
+    result.origin = fillMask.origin;
+    return result;
+}
+
+void GlyphMask::drawEffects(SkCanvas* canvas, const std::vector<MaskEffectLayer>& layers)
+{
+    MaskImage image = effects(layers);
+    if (!image.image)
+        return;
+    canvas->drawImage(image.image, (SkScalar)image.origin.x(), (SkScalar)image.origin.y());
+}
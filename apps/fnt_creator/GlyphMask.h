@@ -0,0 +1,69 @@
+﻿#pragma once
+
+#include "Common.h"
+#include "Utils.h"
+#include "GlyphPathCache.h"
+#include "RenderStyle.h"
+#include <include/core/SkImage.h>
+
+// 覆盖率蒙版(kAlpha_8, 蒙版特效为 kRGBA_8888)及其在页面中的左上角位置
+struct MaskImage
+{
+	sk_sp<SkImage> image;
+	SkIPoint origin;
+};
+
+// 单个字符的覆盖率蒙版缓存
+// 文字填充和描边只光栅化一次, 所有阴影图层都由缓存的蒙版模糊、偏移、着色得到
+// 字符轮廓及描边轮廓从 GlyphPathCache 获取, 描边也可以由填充的距离变换生成
+class GlyphMask
+{
+public:
+
+	// 描边宽度、模糊及描边生成方式取自 paints
+	GlyphMask(const GlyphInfo& glyphInfo, const GlyphPaints& paints, GlyphPathCache& pathCache);
+
+	// 文字填充覆盖率
+	const MaskImage& fill();
+
+	// 文字描边覆盖率, 非居中位置时与填充覆盖率求交集或差集
+	const MaskImage& stroke();
+
+	// 模糊后的填充覆盖率, 相同模糊半径只计算一次
+	const MaskImage& blurredFill(SkScalar sigma);
+
+	// 绘制蒙版, paint 的颜色/渐变/混合模式作用于蒙版
+	void drawMask(SkCanvas* canvas, const MaskImage& mask, const SkPaint& paint, SkScalar dx = 0, SkScalar dy = 0);
+
+	// 绘制阴影图层, 结果与使用 DropShadow 滤镜绘制文字相同
+	void drawShadow(SkCanvas* canvas, const ShadowLayer& layer);
+
+	// 在填充覆盖率上一次计算所有蒙版特效, 合成为一张预乘颜色图片
+	MaskImage effects(const std::vector<MaskEffectLayer>& layers);
+
+	// 绘制蒙版特效
+	void drawEffects(SkCanvas* canvas, const std::vector<MaskEffectLayer>& layers);
+
+private:
+
+	MaskImage rasterize(const SkPath& path);
+
+	// 由字符填充的距离变换生成描边覆盖率
+	MaskImage rasterizeOutline();
+
+	// 描边覆盖率与填充覆盖率求交集(inside)或差集
+	MaskImage clipToFill(const MaskImage& mask, bool inside);
+
+	// 斜面浮雕的明暗(-1~1), 以填充区域(含1像素边界)为范围
+	std::vector<float> bevelShading(const MaskEffect& config);
+
+	const GlyphInfo& m_glyphInfo;
+	SkScalar m_strokeWidth;
+	MaskBlurOptions m_blur;
+	bool m_outlineEdt;
+	OutlinePosition m_outlinePosition;
+	GlyphPathCache& m_pathCache;
+	MaskImage m_fill;
+	MaskImage m_stroke;
+	std::vector<std::pair<SkScalar, MaskImage>> m_blurredFills;
+};
@@ -0,0 +1,86 @@
+﻿#include "GlyphPathCache.h"
+#include "include/core/SkStrokeRec.h"
+
+size_t GlyphPathCache::KeyHash::operator()(const Key& key) const
+{
+    size_t hash = std::hash<uint32_t>()(key.typeface);
+    auto combine = [&hash](size_t value) {
+        hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+    combine(std::hash<uint32_t>()(key.glyph));
+    combine(std::hash<float>()(key.size));
+    combine(std::hash<float>()(key.scaleX));
+    combine(std::hash<float>()(key.skewX));
+    combine(std::hash<bool>()(key.embolden));
+    combine(std::hash<float>()(key.strokeWidth));
+    return hash;
+}
+
+GlyphPathCache::Key GlyphPathCache::makeKey(const SkFont& font, SkGlyphID glyph, SkScalar strokeWidth)
+{
+    Key key;
+    key.typeface = font.getTypefaceOrDefault()->uniqueID();
+    key.glyph = glyph;
+    key.size = font.getSize();
+    key.scaleX = font.getScaleX();
+    key.skewX = font.getSkewX();
+    key.embolden = font.isEmbolden();
+    key.strokeWidth = strokeWidth;
+    return key;
+}
+
+std::shared_ptr<const SkPath> GlyphPathCache::find(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_paths.find(key);
+    if (it != m_paths.end())
+        return it->second;
+    return nullptr;
+}
+
+std::shared_ptr<const SkPath> GlyphPathCache::insert(const Key& key, SkPath&& path)
+{
+    // 其他线程可能已经生成了相同的轮廓, 使用先插入的
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto result = m_paths.emplace(key, std::make_shared<const SkPath>(std::move(path)));
+    return result.first->second;
+}
+
+std::shared_ptr<const SkPath> GlyphPathCache::fill(const SkFont& font, SkGlyphID glyph)
+{
+    Key key = makeKey(font, glyph, 0);
+    if (auto path = find(key))
+        return path;
+
+    // 在锁外提取轮廓
+    SkPath path;
+    font.getPath(glyph, &path);
+    return insert(key, std::move(path));
+}
+
+std::shared_ptr<const SkPath> GlyphPathCache::stroke(const SkFont& font, SkGlyphID glyph, SkScalar strokeWidth)
+{
+    Key key = makeKey(font, glyph, strokeWidth);
+    if (auto path = find(key))
+        return path;
+
+    // 与描边画笔默认的连接方式(miter)、端点(butt)一致
+    SkStrokeRec rec(SkStrokeRec::kHairline_InitStyle);
+    rec.setStrokeStyle(strokeWidth, false);
+
+    SkPath path;
+    rec.applyToPath(&path, *fill(font, glyph));
+    return insert(key, std::move(path));
+}
+
+size_t GlyphPathCache::size()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_paths.size();
+}
+
+void GlyphPathCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_paths.clear();
+}
@@ -0,0 +1,53 @@
+﻿#pragma once
+
+#include "Common.h"
+#include <include/core/SkPath.h>
+#include <memory>
+#include <mutex>
+
+// 字符轮廓缓存
+// 按(字体, 字符, 大小)缓存字符轮廓及描边后的轮廓, 填充、描边、阴影各图层共用, 多线程共享
+class GlyphPathCache
+{
+public:
+
+	// 字符轮廓, 原点为基线起点
+	std::shared_ptr<const SkPath> fill(const SkFont& font, SkGlyphID glyph);
+
+	// 描边后的字符轮廓(使用填充方式绘制)
+	std::shared_ptr<const SkPath> stroke(const SkFont& font, SkGlyphID glyph, SkScalar strokeWidth);
+
+	size_t size();
+
+	void clear();
+
+private:
+
+	struct Key
+	{
+		SkTypefaceID typeface;
+		SkGlyphID glyph;
+		SkScalar size;
+		SkScalar scaleX;
+		SkScalar skewX;
+		bool embolden;
+		// 描边宽度, 0为填充
+		SkScalar strokeWidth;
+
+		bool operator==(const Key&) const = default;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	Key makeKey(const SkFont& font, SkGlyphID glyph, SkScalar strokeWidth);
+
+	std::shared_ptr<const SkPath> find(const Key& key);
+
+	std::shared_ptr<const SkPath> insert(const Key& key, SkPath&& path);
+
+	std::mutex m_mutex;
+	std::unordered_map<Key, std::shared_ptr<const SkPath>, KeyHash> m_paths;
+};
@@ -0,0 +1,303 @@
+﻿#include "MaskBlur.h"
+#include "include/core/SkCanvas.h"
+#include "include/effects/SkImageFilters.h"
+#include <chrono>
+#include <cfloat>
+
+// 盒式模糊近似的标准差与 sigma 的最大相对误差, 超过时使用高斯模糊
+static const float BOX_BLUR_MAX_SIGMA_ERROR = 0.06f;
+
+// 近似标准差为 sigma 的高斯模糊的三个盒式模糊半径, 返回近似标准差的相对误差
+static float boxBlurRadii(SkScalar sigma, int radii[3])
+{
+    const int passes = 3;
+    float ideal = std::sqrt(12.0f * sigma * sigma / passes + 1.0f);
+    int lower = (int)std::floor(ideal);
+    if (lower % 2 == 0)
+        --lower;
+    int upper = lower + 2;
+
+    // 前 m 次使用较小的宽度, 其余使用较大的宽度, 选择总方差最接近 sigma^2 的组合
+    float bestError = FLT_MAX;
+    for (int m = 0; m <= passes; ++m)
+    {
+        int candidate[3];
+        float variance = 0.0f;
+        for (int i = 0; i < passes; ++i)
+        {
+            int size = i < m ? lower : upper;
+            candidate[i] = (size - 1) / 2;
+            variance += (size * size - 1) / 12.0f;
+        }
+
+        float error = std::abs(std::sqrt(variance) - sigma) / sigma;
+        if (error < bestError)
+        {
+            bestError = error;
+            std::copy(candidate, candidate + passes, radii);
+        }
+    }
+    return bestError;
+}
+
+bool boxBlurSupported(SkScalar sigma)
+{
+    if (sigma <= 0.0f)
+        return true;
+
+    int radii[3];
+    return boxBlurRadii(sigma, radii) <= BOX_BLUR_MAX_SIGMA_ERROR;
+}
+
+int maskBlurPadding(SkScalar sigma)
+{
+    if (sigma <= 0.0f)
+        return 0;
+
+    int radii[3];
+    boxBlurRadii(sigma, radii);
+    return std::max((int)std::ceil(sigma * 3.0f), radii[0] + radii[1] + radii[2]);
+}
+
+// 降采样(方差约 scale^2 / 12)和线性插值(方差约 scale^2 / 6)本身带有模糊, 从低分辨率的模糊半径中扣除
+static SkScalar lowResolutionSigma(SkScalar sigma, int scale)
+{
+    return std::sqrt(std::max(sigma * sigma - scale * scale * 0.25f, 0.0f)) / scale;
+}
+
+int maskBlurScale(SkScalar sigma, float maxError)
+{
+    if (maxError <= 0.0f || sigma <= 0.0f)
+        return 1;
+
+    // 模糊后的边缘为 255 * Phi(x / sigma), 二阶导数最大值约为 255 * 0.242 / sigma^2
+    // 间距为 scale 的线性插值误差不超过 scale^2 / 8 * max|f''|
+    // 低分辨率下的模糊半径也需要能用盒式模糊近似
+    for (int scale : { 4, 2 })
+    {
+        float error = scale * scale / 8.0f * 255.0f * 0.242f / (sigma * sigma);
+        if (error <= maxError && boxBlurSupported(lowResolutionSigma(sigma, scale)))
+            return scale;
+    }
+    return 1;
+}
+
+// 对每一列做半径为 radius 的盒式模糊, 范围外视为0
+// 窗口和按行整体更新, 内层循环对一整行连续计算, 便于编译器向量化
+static void boxBlurColumns(const uint8_t* src, uint8_t* dst, int width, int height, int radius, std::vector<uint32_t>& sums)
+{
+    uint32_t size = (uint32_t)(radius * 2 + 1);
+    // 定点数除法, 255 * size * scale 不超过 2^32
+    uint32_t scale = ((1u << 24) + size / 2) / size;
+
+    sums.assign(width, 0);
+    for (int y = 0; y < std::min(radius, height); ++y)
+    {
+        const uint8_t* row = src + (size_t)y * width;
+        for (int x = 0; x < width; ++x)
+            sums[x] += row[x];
+    }
+
+    uint32_t* sum = sums.data();
+    for (int y = 0; y < height; ++y)
+    {
+        // 进入窗口的行
+        if (y + radius < height)
+        {
+            const uint8_t* in = src + (size_t)(y + radius) * width;
+            for (int x = 0; x < width; ++x)
+                sum[x] += in[x];
+        }
+
+        uint8_t* out = dst + (size_t)y * width;
+        for (int x = 0; x < width; ++x)
+            out[x] = (uint8_t)std::min((sum[x] * scale + (1u << 23)) >> 24, 255u);
+
+        // 离开窗口的行
+        if (y - radius >= 0)
+        {
+            const uint8_t* in = src + (size_t)(y - radius) * width;
+            for (int x = 0; x < width; ++x)
+                sum[x] -= in[x];
+        }
+    }
+}
+
+// 分块转置, width x height 转置为 height x width
+static void transpose(const uint8_t* src, uint8_t* dst, int width, int height)
+{
+    const int block = 32;
+    for (int by = 0; by < height; by += block)
+    {
+        for (int bx = 0; bx < width; bx += block)
+        {
+            int ey = std::min(by + block, height);
+            int ex = std::min(bx + block, width);
+            for (int y = by; y < ey; ++y)
+            {
+                for (int x = bx; x < ex; ++x)
+                    dst[(size_t)x * height + y] = src[(size_t)y * width + x];
+            }
+        }
+    }
+}
+
+// 原地模糊 width x height 的单通道缓冲区
+static void blurBuffer(std::vector<uint8_t>& a, int width, int height, SkScalar sigma)
+{
+    int radii[3];
+    boxBlurRadii(sigma, radii);
+    if (radii[0] + radii[1] + radii[2] == 0)
+        return;
+
+    std::vector<uint8_t> b(a.size());
+    std::vector<uint32_t> sums;
+
+    // 垂直方向
+    for (int radius : radii)
+    {
+        boxBlurColumns(a.data(), b.data(), width, height, radius, sums);
+        a.swap(b);
+    }
+
+    // 转置后按列计算水平方向, 再转置回来
+    transpose(a.data(), b.data(), width, height);
+    a.swap(b);
+    for (int radius : radii)
+    {
+        boxBlurColumns(a.data(), b.data(), height, width, radius, sums);
+        a.swap(b);
+    }
+
+    transpose(a.data(), b.data(), height, width);
+    a.swap(b);
+}
+
+void blurMask(const SkPixmap& src, SkScalar sigma, SkBitmap* dst, int scale)
+{
+    int pad = maskBlurPadding(sigma);
+    int width = src.width() + pad * 2;
+    int height = src.height() + pad * 2;
+    dst->allocPixels(SkImageInfo::MakeA8(width, height));
+
+    // 源蒙版放在扩展区域中心
+    std::vector<uint8_t> a((size_t)width * height, 0);
+    for (int y = 0; y < src.height(); ++y)
+        memcpy(&a[(size_t)(y + pad) * width + pad], src.addr8(0, y), src.width());
+
+    if (pad == 0)
+    {
+        dst->writePixels(SkPixmap(dst->info(), a.data(), width));
+        return;
+    }
+
+    if (scale <= 1)
+    {
+        blurBuffer(a, width, height, sigma);
+        dst->writePixels(SkPixmap(dst->info(), a.data(), width));
+        return;
+    }
+
+    // scale x scale 区域平均降采样, 超出范围的部分视为0
+    int lowWidth = (width + scale - 1) / scale;
+    int lowHeight = (height + scale - 1) / scale;
+    std::vector<uint32_t> sums((size_t)lowWidth * lowHeight, 0);
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* row = &a[(size_t)y * width];
+        uint32_t* sum = &sums[(size_t)(y / scale) * lowWidth];
+        for (int x = 0; x < width; ++x)
+            sum[x / scale] += row[x];
+    }
+
+    uint32_t area = (uint32_t)(scale * scale);
+    std::vector<uint8_t> low(sums.size());
+    for (size_t i = 0; i < sums.size(); ++i)
+        low[i] = (uint8_t)((sums[i] + area / 2) / area);
+
+    blurBuffer(low, lowWidth, lowHeight, lowResolutionSigma(sigma, scale));
+
+    // 双线性放大, 低分辨率像素中心位于 (i + 0.5) * scale
+    auto sample = [&](int x, int y) -> float {
+        x = std::min(std::max(x, 0), lowWidth - 1);
+        y = std::min(std::max(y, 0), lowHeight - 1);
+        return low[(size_t)y * lowWidth + x];
+    };
+    float invScale = 1.0f / scale;
+    for (int y = 0; y < height; ++y)
+    {
+        float fy = (y + 0.5f) * invScale - 0.5f;
+        int y0 = (int)std::floor(fy);
+        float ty = fy - y0;
+        uint8_t* out = &a[(size_t)y * width];
+        for (int x = 0; x < width; ++x)
+        {
+            float fx = (x + 0.5f) * invScale - 0.5f;
+            int x0 = (int)std::floor(fx);
+            float tx = fx - x0;
+            float top = sample(x0, y0) + (sample(x0 + 1, y0) - sample(x0, y0)) * tx;
+            float bottom = sample(x0, y0 + 1) + (sample(x0 + 1, y0 + 1) - sample(x0, y0 + 1)) * tx;
+            out[x] = (uint8_t)std::min(top + (bottom - top) * ty + 0.5f, 255.0f);
+        }
+    }
+    dst->writePixels(SkPixmap(dst->info(), a.data(), width));
+}
+
+void benchmarkMaskBlur()
+{
+    using BenchClock = std::chrono::high_resolution_clock;
+
+    const int size = 64;
+    const int iterations = 200;
+    const SkScalar sigmas[] = { 4.0f, 8.0f, 12.0f, 16.0f };
+
+    // 类似字符大小的测试蒙版
+    SkBitmap mask;
+    mask.allocPixels(SkImageInfo::MakeA8(size, size));
+    mask.eraseColor(SK_ColorTRANSPARENT);
+    {
+        SkCanvas canvas(mask);
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        canvas.drawCircle(size * 0.5f, size * 0.5f, size * 0.35f, paint);
+    }
+    sk_sp<SkImage> image = mask.asImage();
+
+    for (auto sigma : sigmas)
+    {
+        int pad = maskBlurPadding(sigma);
+
+        auto begin = BenchClock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            SkBitmap blurred;
+            blurMask(mask.pixmap(), sigma, &blurred);
+        }
+        float boxTime = std::chrono::duration<float, std::milli>(BenchClock::now() - begin).count() / iterations;
+
+        begin = BenchClock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            SkBitmap blurred;
+            blurred.allocPixels(SkImageInfo::MakeA8(size + pad * 2, size + pad * 2));
+            blurred.eraseColor(SK_ColorTRANSPARENT);
+            SkCanvas canvas(blurred);
+            SkPaint paint;
+            paint.setImageFilter(SkImageFilters::Blur(sigma, sigma, nullptr));
+            canvas.drawImage(image, (SkScalar)pad, (SkScalar)pad, SkSamplingOptions(), &paint);
+        }
+        float skiaTime = std::chrono::duration<float, std::milli>(BenchClock::now() - begin).count() / iterations;
+
+        // 误差1个灰度级时的降采样模糊
+        int scale = maskBlurScale(sigma, 1.0f);
+        begin = BenchClock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            SkBitmap blurred;
+            blurMask(mask.pixmap(), sigma, &blurred, scale);
+        }
+        float scaledTime = std::chrono::duration<float, std::milli>(BenchClock::now() - begin).count() / iterations;
+
+        printf("blur %dx%d sigma=%.1f: box %.3f ms, box 1/%d %.3f ms, skia %.3f ms\n", size, size, sigma, boxTime, scale, scaledTime, skiaTime);
+    }
+}
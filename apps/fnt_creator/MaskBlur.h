@@ -0,0 +1,33 @@
+﻿#pragma once
+
+#include "Common.h"
+#include <include/core/SkBitmap.h>
+
+// 覆盖率蒙版(kAlpha_8)模糊
+// 以三次盒式模糊近似高斯模糊, 水平、垂直方向分离计算, 每次盒式模糊使用滑动窗口求和
+// 只处理单通道, 颜色及偏移在绘制蒙版时应用
+
+// 蒙版模糊选项
+struct MaskBlurOptions
+{
+	// 使用盒式模糊, 否则使用 SkImageFilters::Blur
+	bool box;
+	// 降采样允许的最大误差(灰度级), <=0 不降采样
+	float maxError;
+};
+
+// sigma 能否用三次盒式模糊近似(标准差误差不超过6%), 较小的 sigma 需要使用高斯模糊
+bool boxBlurSupported(SkScalar sigma);
+
+// 模糊后蒙版四周扩展的像素数
+int maskBlurPadding(SkScalar sigma);
+
+// 误差不超过 maxError 时可使用的降采样倍数(1、2 或 4)
+int maskBlurScale(SkScalar sigma, float maxError);
+
+// 模糊 src, 结果写入 dst(四周各扩展 maskBlurPadding(sigma) 像素), sigma 需满足 boxBlurSupported
+// scale > 1 时先按 scale x scale 区域平均降采样, 在低分辨率下模糊后双线性放大
+void blurMask(const SkPixmap& src, SkScalar sigma, SkBitmap* dst, int scale = 1);
+
+// 与 SkImageFilters::Blur 对比模糊耗时, 结果输出到控制台
+void benchmarkMaskBlur();
@@ -0,0 +1,106 @@
+﻿#include "RenderStyle.h"
+
+RenderStyle::RenderStyle()
+    : m_compiled(false)
+{
+    m_paints.backgroundColor = SK_ColorTRANSPARENT;
+    m_paints.debugAllAreaColor = SK_ColorTRANSPARENT;
+    m_paints.debugOutlineThicknessAreaColor = SK_ColorTRANSPARENT;
+    m_paints.debugRawAreaColor = SK_ColorTRANSPARENT;
+    m_paints.debugRealAreaColor = SK_ColorTRANSPARENT;
+    m_paints.useMask = true;
+    m_paints.blur = MaskBlurOptions{ false, 0.0f };
+    m_paints.outlineEdt = false;
+    m_paints.outlinePosition = OutlinePosition::Center;
+    m_paints.overflow = 0;
+}
+
+const GlyphPaints& RenderStyle::compile(const GenerateConfig& config)
+{
+    auto& style = config.text_style;
+    auto& last = m_textStyle;
+    bool all = !m_compiled;
+
+    // 文字画笔
+    if (all || style.color != last.color || style.blend_mode != last.blend_mode)
+        m_paints.textPaint = createPaint(style.color, style.blend_mode);
+
+    // 文字特效着色器, 每个字符通过局部矩阵定位
+    if (all || style.effect != last.effect)
+        m_paints.textEffect = createEffectShader(style.effect);
+
+    // 文字阴影图层
+    if (all || style.shadows != last.shadows)
+        m_paints.textShadowLayers = compileShadowLayers(style.shadows);
+
+    // 文字描边画笔
+    if (all || style.outline_color != last.outline_color || style.outline_blend_mode != last.outline_blend_mode
+        || style.outline_thickness != last.outline_thickness || style.outline_thickness_render_scale != last.outline_thickness_render_scale)
+    {
+        m_paints.outlinePaint = createPaint(style.outline_color, style.outline_blend_mode);
+        m_paints.outlinePaint.setStyle(SkPaint::kStroke_Style);
+        m_paints.outlinePaint.setStrokeWidth(style.outline_thickness <= 0 ? 1 : style.outline_thickness * style.outline_thickness_render_scale);
+    }
+
+    // 描边特效着色器
+    if (all || style.outline_effect != last.outline_effect)
+        m_paints.outlineEffect = createEffectShader(style.outline_effect);
+
+    // 描边阴影图层
+    if (all || style.outline_shadows != last.outline_shadows)
+        m_paints.outlineShadowLayers = compileShadowLayers(style.outline_shadows);
+
+    // 蒙版特效
+    if (all || style.mask_effects != last.mask_effects)
+        m_paints.maskEffects = compileMaskEffects(style.mask_effects);
+
+    if (style.outline_position == "inside")
+        m_paints.outlinePosition = OutlinePosition::Inside;
+    else if (style.outline_position == "outside")
+        m_paints.outlinePosition = OutlinePosition::Outside;
+    else
+        m_paints.outlinePosition = OutlinePosition::Center;
+
+    if (all || style.background_color != last.background_color)
+        m_paints.backgroundColor = stringToSkColor(style.background_color);
+
+    // 调试区域颜色
+    const std::string* debugColors[4] = {
+        &config.color_debug_draw_glyph_all_area,
+        &config.color_debug_draw_glyph_outline_thickness_area,
+        &config.color_debug_draw_glyph_raw_area,
+        &config.color_debug_draw_glyph_real_area,
+    };
+    SkColor* debugValues[4] = {
+        &m_paints.debugAllAreaColor,
+        &m_paints.debugOutlineThicknessAreaColor,
+        &m_paints.debugRawAreaColor,
+        &m_paints.debugRealAreaColor,
+    };
+    for (int i = 0; i < 4; ++i)
+    {
+        if (all || *debugColors[i] != m_debugColors[i])
+        {
+            *debugValues[i] = stringToSkColor(*debugColors[i]);
+            m_debugColors[i] = *debugColors[i];
+        }
+    }
+
+    // 使用覆盖率蒙版绘制
+    m_paints.useMask = config.shadow_mode != "filter";
+    m_paints.blur = MaskBlurOptions{ config.blur_engine == "box", config.blur_max_error };
+    m_paints.outlineEdt = config.outline_engine == "edt";
+
+    // 字符绘制可能超出字符区域的距离(描边及阴影)
+    SkScalar strokeWidth = m_paints.outlinePaint.getStrokeWidth();
+    SkScalar overflow = strokeWidth;
+    for (auto& shadowLayer : m_paints.outlineShadowLayers)
+        overflow = std::max(overflow, strokeWidth + shadowLayer.config.blur_radius * 3.0f + std::max(std::abs(shadowLayer.config.offsetx), std::abs(shadowLayer.config.offsety)));
+    for (auto& shadowLayer : m_paints.textShadowLayers)
+        overflow = std::max(overflow, shadowLayer.config.blur_radius * 3.0f + std::max(std::abs(shadowLayer.config.offsetx), std::abs(shadowLayer.config.offsety)));
+    m_paints.overflow = (int)std::ceil(overflow) + 2;
+
+    m_textStyle = style;
+    m_compiled = true;
+    return m_paints;
+}
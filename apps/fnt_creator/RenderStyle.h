@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include "Common.h"
+#include "Utils.h"
+#include "MaskBlur.h"
+
+// 描边位置
+enum class OutlinePosition
+{
+	Center,
+	Inside,
+	Outside,
+};
+
+// 编译后的渲染样式, 绘制字符时只读取, 可在多个线程中共享
+struct GlyphPaints
+{
+	SkPaint outlinePaint;
+	SkPaint textPaint;
+	std::vector<ShadowLayer> outlineShadowLayers;
+	std::vector<ShadowLayer> textShadowLayers;
+	// 蒙版特效
+	std::vector<MaskEffectLayer> maskEffects;
+	OutlinePosition outlinePosition;
+	// 描边及文字特效着色器
+	EffectShader outlineEffect;
+	EffectShader textEffect;
+	// 背景颜色
+	SkColor backgroundColor;
+	// 调试区域颜色
+	SkColor debugAllAreaColor;
+	SkColor debugOutlineThicknessAreaColor;
+	SkColor debugRawAreaColor;
+	SkColor debugRealAreaColor;
+	// 使用覆盖率蒙版绘制
+	bool useMask;
+	// 蒙版模糊选项
+	MaskBlurOptions blur;
+	// 描边由距离变换生成
+	bool outlineEdt;
+
+	// 描边需要使用覆盖率蒙版绘制(距离变换生成或非居中位置)
+	bool outlineFromMask() const { return outlineEdt || outlinePosition != OutlinePosition::Center; }
+	// 字符绘制可能超出字符区域的距离(描边及阴影)
+	int overflow;
+};
+
+// 将 TextStyle 及调试配置中的颜色、混合模式、着色器、阴影滤镜解析为 GlyphPaints
+// 保留上次编译的配置, 再次编译时只重新解析发生变化的部分(编辑器中反复预览)
+class RenderStyle
+{
+public:
+
+	RenderStyle();
+
+	const GlyphPaints& compile(const GenerateConfig& config);
+
+	const GlyphPaints& paints() const { return m_paints; }
+
+private:
+
+	bool m_compiled;
+	TextStyle m_textStyle;
+	std::string m_debugColors[4];
+	GlyphPaints m_paints;
+};
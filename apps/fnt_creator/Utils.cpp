@@ -1,8 +1,10 @@
 ﻿#include "Utils.h"
 #include <sstream>
+#include <fstream>
 #include <iomanip>
 #include "include/effects/SkGradientShader.h"
 #include "include/effects/SkImageFilters.h"
+#include "include/core/SkColorFilter.h"
 #include "tinyutf8.h"
 
 std::string stringFormat(const char* format, ...)
@@ -121,6 +123,104 @@ int calculateHeight(const FntPage& page, const GenerateConfig& config, int maxWi
     }
 }
 
+size_t fitGlyphCount(const std::vector<GlyphInfo>& glyphs, size_t first, const GenerateConfig& config, int maxWidth, int maxPageHeight)
+{
+    // 字符增加的宽高
+    int glyhMargin = config.text_style.outline_thickness;
+    int x = config.padding_left;
+    int y = config.padding_up;
+    int maxHeight = 0;
+
+    size_t count = 0;
+    for (size_t i = first; i < glyphs.size(); ++i)
+    {
+        auto& glyphInfo = glyphs[i];
+
+        // 字符宽高（字符宽高+描边大小）
+        int glyphWidth = glyphInfo.width + glyhMargin * 2;
+        int glyphHeight = glyphInfo.height + glyhMargin * 2;
+
+        // 字符实际宽高（包括字符预留距离）
+        int glyphRealWidth = glyphWidth + glyphInfo.padding_left + glyphInfo.padding_right + config.glyph_padding_left + config.glyph_padding_right;
+        int glyphRealHeight = glyphHeight + glyphInfo.padding_up + glyphInfo.padding_down + config.glyph_padding_up + config.glyph_padding_down;
+
+        int rowY = y;
+        int rowHeight = std::max(maxHeight, glyphRealHeight);
+        int rowX = x;
+        if (x + glyphRealWidth + config.padding_right >= maxWidth)
+        {
+            rowY = y + maxHeight + config.spacing_glyph_y;
+            rowHeight = glyphRealHeight;
+            rowX = config.padding_left;
+        }
+
+        int height = rowY + rowHeight;
+        if (config.is_NPOT)
+        {
+            if (nextPOT(height) - height < config.padding_down)
+                height = height + config.padding_down;
+            height = nextPOT(height);
+        }
+        else
+        {
+            height = height + config.padding_down;
+        }
+
+        if (height > maxPageHeight && count > 0)
+            break;
+
+        y = rowY;
+        maxHeight = rowHeight;
+        x = rowX + glyphRealWidth + config.spacing_glyph_x;
+        ++count;
+    }
+    return std::max(count, (size_t)1);
+}
+
+std::vector<size_t> balanceGlyphCounts(const std::vector<GlyphInfo>& glyphs, const GenerateConfig& config, size_t pageCount)
+{
+    pageCount = std::max(std::min(pageCount, glyphs.size()), (size_t)1);
+
+    // 字符增加的宽高
+    int glyhMargin = config.text_style.outline_thickness;
+
+    std::vector<double> areas;
+    areas.reserve(glyphs.size());
+    double totalArea = 0.0;
+    for (auto& glyphInfo : glyphs)
+    {
+        int glyphRealWidth = glyphInfo.width + glyhMargin * 2 + glyphInfo.padding_left + glyphInfo.padding_right + config.glyph_padding_left + config.glyph_padding_right + config.spacing_glyph_x;
+        int glyphRealHeight = glyphInfo.height + glyhMargin * 2 + glyphInfo.padding_up + glyphInfo.padding_down + config.glyph_padding_up + config.glyph_padding_down + config.spacing_glyph_y;
+        double area = (double)glyphRealWidth * glyphRealHeight;
+        areas.push_back(area);
+        totalArea += area;
+    }
+
+    std::vector<size_t> counts;
+    counts.reserve(pageCount);
+
+    size_t first = 0;
+    double accumulated = 0.0;
+    for (size_t page = 0; page + 1 < pageCount; ++page)
+    {
+        double target = totalArea * (page + 1) / pageCount;
+        // 至少为剩余的页面各保留一个字符
+        size_t last = glyphs.size() - (pageCount - page - 1);
+        size_t end = first + 1;
+        accumulated += areas[first];
+        while (end < last && accumulated + areas[end] * 0.5 < target)
+        {
+            accumulated += areas[end];
+            ++end;
+        }
+        counts.push_back(end - first);
+        first = end;
+    }
+    counts.push_back(glyphs.size() - first);
+
+    return counts;
+}
+
 std::vector<char32_t> collectCodepoints(const PageConfig& config)
 {
     std::set<char32_t> charSet;
@@ -151,6 +251,225 @@ std::vector<char32_t> collectCodepoints(const PageConfig& config)
     return codepoints;
 }
 
+std::vector<std::vector<char32_t>> collectPagesCodepoints(const GenerateConfig& config, const std::function<bool(size_t pageIndex, char32_t codepoint)>& hasGlyph)
+{
+    std::vector<std::vector<char32_t>> pagesCodepoints;
+    pagesCodepoints.reserve(config.pages.size());
+    for (auto& pageCfg : config.pages)
+    {
+        pagesCodepoints.push_back(collectCodepoints(pageCfg));
+    }
+
+    if (config.codepoint_owner == "none")
+        return pagesCodepoints;
+
+    bool usePriority = config.codepoint_owner == "priority";
+    if (!usePriority && config.codepoint_owner != "first_page")
+    {
+        std::cerr << "invalid codepoint_owner: " << config.codepoint_owner << ", using first_page" << std::endl;
+    }
+
+    // 字符 -> 包含该字符的页面(按页面顺序)
+    std::unordered_map<char32_t, std::vector<size_t>> codepointPages;
+    for (size_t i = 0; i < pagesCodepoints.size(); ++i)
+    {
+        for (auto codepoint : pagesCodepoints[i])
+            codepointPages[codepoint].push_back(i);
+    }
+
+    // 页面 candidate 是否优先于 owner
+    auto preferred = [&](size_t candidate, size_t owner) {
+        return usePriority && config.pages[candidate].priority > config.pages[owner].priority;
+    };
+
+    // 字符 -> 所属页面
+    std::unordered_map<char32_t, size_t> owners;
+    owners.reserve(codepointPages.size());
+    for (auto& it : codepointPages)
+    {
+        auto& pages = it.second;
+        if (pages.size() == 1)
+        {
+            owners.emplace(it.first, pages[0]);
+            continue;
+        }
+
+        // 优先选择字体包含该字符的页面
+        size_t owner = SIZE_MAX;
+        for (auto page : pages)
+        {
+            if ((owner == SIZE_MAX || preferred(page, owner)) && hasGlyph(page, it.first))
+                owner = page;
+        }
+
+        if (owner == SIZE_MAX)
+        {
+            owner = pages[0];
+            for (auto page : pages)
+            {
+                if (preferred(page, owner))
+                    owner = page;
+            }
+        }
+        owners.emplace(it.first, owner);
+    }
+
+    size_t removed = 0;
+    for (size_t i = 0; i < pagesCodepoints.size(); ++i)
+    {
+        auto& codepoints = pagesCodepoints[i];
+        auto size = codepoints.size();
+        codepoints.erase(std::remove_if(codepoints.begin(), codepoints.end(), [&](char32_t codepoint) {
+            return owners[codepoint] != i;
+        }), codepoints.end());
+        removed += size - codepoints.size();
+    }
+
+    if (removed > 0)
+    {
+        printf("removed %d duplicate characters across pages\n", (int)removed);
+    }
+
+    return pagesCodepoints;
+}
+
+std::unordered_map<char32_t, double> loadGlyphFrequency(const std::string& filename, const std::string& format)
+{
+    std::unordered_map<char32_t, double> frequency;
+
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "failed to open frequency file: " << filename << std::endl;
+        return frequency;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string content = buffer.str();
+    // 去除UTF-8 BOM
+    if (content.size() >= 3 && content.compare(0, 3, "\xEF\xBB\xBF") == 0)
+        content.erase(0, 3);
+
+    if (format == "corpus")
+    {
+        tiny_utf8::string utf8_text = content;
+        for_each(utf8_text.begin(), utf8_text.end(), [&](char32_t codepoint)
+        {
+            if (codepoint != char32_t('\r') && codepoint != char32_t('\n'))
+                frequency[codepoint] += 1.0;
+        });
+        return frequency;
+    }
+
+    if (format != "counts")
+    {
+        std::cerr << "invalid frequency_format: " << format << ", using counts" << std::endl;
+    }
+
+    std::istringstream lines(content);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line))
+    {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream iss(line);
+        std::string token;
+        double count = 0.0;
+        if (!(iss >> token >> count))
+        {
+            std::cerr << "invalid frequency line " << lineNumber << ": " << line << std::endl;
+            continue;
+        }
+
+        char32_t codepoint = 0;
+        tiny_utf8::string utf8_token = token;
+        if (token.size() > 2 && (token[0] == 'U' || token[0] == 'u') && token[1] == '+')
+        {
+            codepoint = (char32_t)std::strtoul(token.c_str() + 2, nullptr, 16);
+        }
+        else if (utf8_token.length() == 1)
+        {
+            codepoint = utf8_token[0];
+        }
+        else
+        {
+            codepoint = (char32_t)std::strtoul(token.c_str(), nullptr, 10);
+        }
+        frequency[codepoint] += count;
+    }
+
+    return frequency;
+}
+
+bool isDistanceFieldMode(const GenerateConfig& config)
+{
+    return config.render_mode == "sdf" || config.render_mode == "msdf";
+}
+
+int pageMaxWidth(const GenerateConfig& config)
+{
+    if (config.fitted_width > 0)
+        return std::min(config.max_width, config.fitted_width);
+    return config.max_width;
+}
+
+int pageMaxHeight(const GenerateConfig& config)
+{
+    // max_height <= 0 不限制
+    if (config.fitted_height > 0)
+        return config.max_height > 0 ? std::min(config.max_height, config.fitted_height) : config.fitted_height;
+    return config.max_height;
+}
+
+bool isMonochromeStyle(const TextStyle& style)
+{
+    SkColor color = stringToSkColor(style.color);
+    auto sameColor = [color](const std::string& value) {
+        return (stringToSkColor(value) & 0x00FFFFFF) == (color & 0x00FFFFFF);
+    };
+    auto isSrcOver = [](const std::string& blendMode) {
+        return blendMode.empty() || blendMode == "SrcOver";
+    };
+
+    if (style.effect.effect_type == "linear_gradient" || !isSrcOver(style.blend_mode) || !style.mask_effects.empty())
+        return false;
+
+    for (auto& shadow : style.shadows)
+    {
+        if (!sameColor(shadow.color) || !isSrcOver(shadow.blend_mode))
+            return false;
+    }
+
+    if (style.outline_thickness > 0)
+    {
+        if (style.outline_effect.effect_type == "linear_gradient" || !sameColor(style.outline_color) || !isSrcOver(style.outline_blend_mode))
+            return false;
+
+        for (auto& shadow : style.outline_shadows)
+        {
+            if (!sameColor(shadow.color) || !isSrcOver(shadow.blend_mode))
+                return false;
+        }
+    }
+
+    // 背景完全透明或与文字颜色相同
+    SkColor background = stringToSkColor(style.background_color);
+    return SkColorGetA(background) == 0 || sameColor(style.background_color);
+}
+
+SkImageInfo makePageImageInfo(const GenerateConfig& config, int width, int height)
+{
+    if (config.output_format == "a8")
+        return SkImageInfo::MakeA8(width, height);
+    return SkImageInfo::Make(width, height, kRGBA_8888_SkColorType, kUnpremul_SkAlphaType);
+}
+
 // 获取字符的度量信息
 GlyphInfo getGlyphInfo(SkFont font, char32_t codepoint)
 {
@@ -161,6 +480,7 @@ GlyphInfo getGlyphInfo(SkFont font, char32_t codepoint)
     memset(&glyphInfo, 0, sizeof(glyphInfo));
     glyphInfo.codepoint = codepoint;
     glyphInfo.font = font;
+    glyphInfo.glyph_id = font.unicharToGlyph((SkUnichar)codepoint);
     glyphInfo.x = 0;
     glyphInfo.y = 0;
     glyphInfo.width = (int)std::ceilf(bounds.width());
@@ -186,54 +506,56 @@ SkFontStyle getFontStyle(bool isBold, bool isItalic)
 }
 
 // 解析十六进制字符串为整数
-int hexToInt(const std::string& hex, bool* ok)
+// 解析两位16进制数
+static int hexByteToInt(const char* hex, bool* ok)
 {
-    int value;
-    std::istringstream iss(hex);
-    iss >> std::hex >> value;
-    if (iss.fail()) 
-    {
-        if (ok)
-            *ok = false;
-        return 0;
+    int value = 0;
+    for (int i = 0; i < 2; ++i)
+    {
+        char c = hex[i];
+        int digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+        else
+        {
+            if (ok)
+                *ok = false;
+            return 0;
+        }
+        value = value * 16 + digit;
     }
     return value;
 }
 
-static std::unordered_map<std::string, SkColor> colorMap;
-
 SkColor stringToSkColor(const std::string hex)
 {
-    //auto it = colorMap.find(hex);
-    //if (it != colorMap.end())
-    //    return it->second;
-
     if (hex.empty() || hex[0] != '#')
     {
         std::cerr << "invalid color: " << hex << std::endl;
-        //colorMap.insert(std::make_pair(hex, SK_ColorBLACK));
         return SK_ColorBLACK;
     }
-    std::string hex_color = hex;
-    while (hex_color.size() < 9)
-    {
-        hex_color.append("F");
-    }
+
+    // 不足的部分补F
+    char hex_color[9] = { '#', 'F', 'F', 'F', 'F', 'F', 'F', 'F', 'F' };
+    for (size_t i = 1; i < hex.size() && i < 9; ++i)
+        hex_color[i] = hex[i];
 
     bool ok = true;
-    int r = hexToInt(hex_color.substr(1, 2), &ok);  // Red
-    int g = hexToInt(hex_color.substr(3, 2), &ok);  // Green
-    int b = hexToInt(hex_color.substr(5, 2), &ok);  // Blue
-    int a = hexToInt(hex_color.substr(7, 2), &ok);  // Alpha
+    int r = hexByteToInt(hex_color + 1, &ok);  // Red
+    int g = hexByteToInt(hex_color + 3, &ok);  // Green
+    int b = hexByteToInt(hex_color + 5, &ok);  // Blue
+    int a = hexByteToInt(hex_color + 7, &ok);  // Alpha
 
     if (!ok)
     {
         std::cerr << "invalid color: " << hex << std::endl;
     }
 
-    auto color = SkColorSetARGB((U8CPU)a, (U8CPU)r, (U8CPU)g, (U8CPU)b);
-    //colorMap.insert(std::make_pair(hex, color));
-    return color;
+    return SkColorSetARGB((U8CPU)a, (U8CPU)r, (U8CPU)g, (U8CPU)b);
 }
 
 // 将 RGBA 转换为 #RRGGBBAA 格式的字符串
@@ -292,6 +614,22 @@ static NameModePair ModeMap[] = {
     { "LastMode", SkBlendMode::kLastMode },
 };
 
+bool stringToBlendMode(const std::string& name, SkBlendMode* mode)
+{
+    static const std::unordered_map<std::string, SkBlendMode> modes = [] {
+        std::unordered_map<std::string, SkBlendMode> map;
+        for (auto& it : ModeMap)
+            map.emplace(it.name, it.mode);
+        return map;
+    }();
+
+    auto it = modes.find(name);
+    if (it == modes.end())
+        return false;
+    *mode = it->second;
+    return true;
+}
+
 SkPaint createPaint(const std::string& color, const std::string& blend_mode)
 {
     SkPaint paint;
@@ -299,29 +637,34 @@ SkPaint createPaint(const std::string& color, const std::string& blend_mode)
     paint.setColor(stringToSkColor(color));
 
     // 混合模式设置
-    if (!blend_mode.empty())
-    {
-        for (auto i = 0; i < sizeof(ModeMap) / sizeof(ModeMap[0]); ++i)
-        {
-            if (blend_mode == ModeMap[i].name)
-            {
-                paint.setBlendMode(ModeMap[i].mode);
-                break;
-            }
-        }
-    }
-
+    SkBlendMode mode;
+    if (!blend_mode.empty() && stringToBlendMode(blend_mode, &mode))
+        paint.setBlendMode(mode);
 
     return paint;
 }
 
-void setPaintShader(SkPaint& paint, const TextEffect& effect, SkScalar x, SkScalar y, SkScalar w, SkScalar h)
+EffectShader createEffectShader(const TextEffect& effect)
 {
+    EffectShader result;
+    result.begin = SkPoint::Make(0, 0);
+    result.end = SkPoint::Make(0, 0);
+    result.degenerate = false;
+
     if (effect.effect_type == "linear_gradient")
     {
         auto& params = effect.linear_gradient;
 
-        SkPoint pts[2]{ SkPoint::Make(x + w * params.begin.x, y + h * params.begin.y), SkPoint::Make(x + w * params.end.x, y + h * params.end.y) };
+        result.begin = SkPoint::Make(params.begin.x, params.begin.y);
+        result.end = SkPoint::Make(params.end.x, params.end.y);
+        result.degenerate = result.begin == result.end;
+
+        SkPoint pts[2]{ SkPoint::Make(0, 0), SkPoint::Make(1, 0) };
+        if (result.degenerate)
+        {
+            pts[0] = result.begin;
+            pts[1] = result.end;
+        }
 
         std::vector<SkColor> colors;
         colors.reserve(params.colors.capacity());
@@ -336,16 +679,34 @@ void setPaintShader(SkPaint& paint, const TextEffect& effect, SkScalar x, SkScal
         }
 
         if (params.pos.size() < 2)
-        {
-            auto shader = SkGradientShader::MakeLinear(pts, &colors[0], nullptr, (int)colors.size(), SkTileMode::kClamp);
-            paint.setShader(shader);
-        }
+            result.shader = SkGradientShader::MakeLinear(pts, &colors[0], nullptr, (int)colors.size(), SkTileMode::kClamp);
         else
-        {
-            auto shader = SkGradientShader::MakeLinear(pts, &colors[0], &params.pos[0], (int)std::min(colors.size(), params.pos.size()), SkTileMode::kClamp);
-            paint.setShader(shader);
-        }
+            result.shader = SkGradientShader::MakeLinear(pts, &colors[0], &params.pos[0], (int)std::min(colors.size(), params.pos.size()), SkTileMode::kClamp);
     }
+    return result;
+}
+
+void setPaintShader(SkPaint& paint, const EffectShader& effect, SkScalar x, SkScalar y, SkScalar w, SkScalar h)
+{
+    if (!effect.shader)
+        return;
+
+    if (effect.degenerate)
+    {
+        paint.setShader(effect.shader);
+        return;
+    }
+
+    SkPoint begin = SkPoint::Make(x + w * effect.begin.x(), y + h * effect.begin.y());
+    SkPoint end = SkPoint::Make(x + w * effect.end.x(), y + h * effect.end.y());
+    SkVector dir = end - begin;
+
+    // (1,0) 映射到渐变方向, (0,1) 映射到其垂直方向, 与直接使用起止点创建的渐变一致
+    SkMatrix matrix = SkMatrix::MakeAll(
+        dir.x(), -dir.y(), begin.x(),
+        dir.y(), dir.x(), begin.y(),
+        0, 0, 1);
+    paint.setShader(effect.shader->makeWithLocalMatrix(matrix));
 }
 
 SkPaint createShadowPaint(const TextShadow& config)
@@ -362,16 +723,77 @@ SkPaint createShadowPaint(const TextShadow& config)
     return paint;
 }
 
-std::vector<SkPaint> createShadowPaints(const std::vector<TextShadow>& configs)
+sk_sp<SkColorFilter> makeRepeatAlphaFilter(int count)
 {
-    if (configs.empty())
-        return {};
+    uint8_t table[256];
+    for (int i = 0; i < 256; ++i)
+    {
+        double alpha = 1.0 - std::pow(1.0 - i / 255.0, count);
+        table[i] = (uint8_t)std::lround(alpha * 255.0);
+    }
+    return SkColorFilters::TableARGB(table, nullptr, nullptr, nullptr);
+}
 
-    std::vector<SkPaint> paints;
+std::vector<MaskEffectLayer> compileMaskEffects(const std::vector<MaskEffect>& configs)
+{
+    std::vector<MaskEffectLayer> layers;
+    for (auto& config : configs)
+    {
+        if (config.effect_type != "inner_shadow" && config.effect_type != "inner_glow" && config.effect_type != "bevel")
+        {
+            std::cerr << "unknown mask effect: " << config.effect_type << std::endl;
+            continue;
+        }
+        layers.push_back(MaskEffectLayer{ config, stringToSkColor(config.color), stringToSkColor(config.highlight_color), stringToSkColor(config.shadow_color) });
+    }
+    return layers;
+}
+
+std::vector<ShadowLayer> compileShadowLayers(const std::vector<TextShadow>& configs)
+{
+    std::vector<ShadowLayer> layers;
+    layers.reserve(configs.size());
 
+    // 当前可交换顺序的图层范围起点
+    // SrcOver 混合时颜色(RGB)相同的图层交换绘制顺序结果不变, 因此范围内的相同图层可以合并
+    size_t runStart = 0;
     for (auto& config : configs)
     {
-        paints.push_back(createShadowPaint(config));
+        SkPaint paint = createShadowPaint(config);
+        SkColor color = paint.getColor();
+
+        bool merged = false;
+        if (paint.isSrcOver() && runStart < layers.size() && layers[runStart].paint.isSrcOver() && SkColorSetA(layers[runStart].paint.getColor(), 0) == SkColorSetA(color, 0))
+        {
+            for (size_t i = runStart; i < layers.size(); ++i)
+            {
+                auto& layer = layers[i];
+                if (layer.paint.getColor() == color && layer.config.offsetx == config.offsetx && layer.config.offsety == config.offsety && layer.config.blur_radius == config.blur_radius)
+                {
+                    layer.count++;
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            runStart = layers.size();
+        }
+
+        if (!merged)
+        {
+            layers.push_back(ShadowLayer{ config, 1, paint });
+        }
+    }
+
+    for (auto& layer : layers)
+    {
+        if (layer.count > 1)
+        {
+            layer.paint.setImageFilter(SkImageFilters::ColorFilter(makeRepeatAlphaFilter(layer.count), layer.paint.refImageFilter()));
+        }
     }
-    return paints;
-}
\ No newline at end of file
+
+    return layers;
+}
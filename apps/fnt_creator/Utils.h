@@ -1,6 +1,8 @@
 ﻿#pragma once
 
 #include "Common.h"
+#include <include/core/SkShader.h>
+#include <functional>
 
 std::string stringFormat(const char* format, ...);
 
@@ -12,8 +14,35 @@ int getMinWidth(const FntPage& page, const GenerateConfig& config);
 
 int calculateHeight(const FntPage& page, const GenerateConfig& config, int maxWidth);
 
+// 从first开始, 在maxWidth x maxPageHeight内最多能排列的字符数量(至少为1)
+size_t fitGlyphCount(const std::vector<GlyphInfo>& glyphs, size_t first, const GenerateConfig& config, int maxWidth, int maxPageHeight);
+
+// 将字符按占用面积均分为pageCount份(保持字符顺序), 返回每份的字符数量
+std::vector<size_t> balanceGlyphCounts(const std::vector<GlyphInfo>& glyphs, const GenerateConfig& config, size_t pageCount);
+
 std::vector<char32_t> collectCodepoints(const PageConfig& config);
 
+// 收集所有页面的字符, 并按 codepoint_owner 规则去除跨页面重复的字符
+// 多个页面包含相同字符时, 只在页面字体包含该字符(hasGlyph 返回 true)的页面中选择归属页面
+// 所有页面的字体都不包含该字符时, 在全部页面中选择(使用系统字体回退)
+std::vector<std::vector<char32_t>> collectPagesCodepoints(const GenerateConfig& config, const std::function<bool(size_t pageIndex, char32_t codepoint)>& hasGlyph);
+
+// 读取字符使用频率表
+std::unordered_map<char32_t, double> loadGlyphFrequency(const std::string& filename, const std::string& format);
+
+// 是否输出距离场(sdf, msdf)
+bool isDistanceFieldMode(const GenerateConfig& config);
+
+// 排版使用的页面最大宽高, 自动适配时取 fit_to 页面宽高与 max_width/max_height 的较小值
+int pageMaxWidth(const GenerateConfig& config);
+int pageMaxHeight(const GenerateConfig& config);
+
+// 样式是否为单色(无渐变, 各图层颜色相同且使用默认混合模式), 单色样式只需输出透明度
+bool isMonochromeStyle(const TextStyle& style);
+
+// 页面位图格式, a8 输出为 kAlpha_8, 否则为非预乘 RGBA
+SkImageInfo makePageImageInfo(const GenerateConfig& config, int width, int height);
+
 // 获取字符的度量信息
 GlyphInfo getGlyphInfo(SkFont font, char32_t codepoint);
 
@@ -23,8 +52,52 @@ SkColor stringToSkColor(const std::string hex);
 
 std::string rgbaToHex(int r, int g, int b, int a);
 
+// 按名称查找混合模式, 名称无效时返回false
+bool stringToBlendMode(const std::string& name, SkBlendMode* mode);
+
 SkPaint createPaint(const std::string& color, const std::string& blend_mode);
 
-void setPaintShader(SkPaint& paint, const TextEffect& config, SkScalar x, SkScalar y, SkScalar w, SkScalar h);
+// 文字特效着色器, 在单位坐标空间中只创建一次
+// 线性渐变统一为(0,0)到(1,0), 绘制每个字符时通过局部矩阵映射到实际的起止位置
+struct EffectShader
+{
+    sk_sp<SkShader> shader;
+    // 起止位置(相对字符区域, 0~1)
+    SkPoint begin;
+    SkPoint end;
+    // 起止位置相同, 着色器为纯色, 不需要定位
+    bool degenerate;
+};
+
+EffectShader createEffectShader(const TextEffect& config);
+
+void setPaintShader(SkPaint& paint, const EffectShader& effect, SkScalar x, SkScalar y, SkScalar w, SkScalar h);
+
+// 阴影图层
+struct ShadowLayer
+{
+    TextShadow config;
+    // 合并的相同图层数量
+    int count;
+    // 图层画笔(包含 DropShadow 滤镜)
+    SkPaint paint;
+};
+
+// 编译阴影图层: 合并连续 SrcOver 且颜色相同的图层中重复的图层
+// N个相同图层只绘制一次, 透明度按 1-(1-a)^N 合成, 结果与逐层绘制相同
+std::vector<ShadowLayer> compileShadowLayers(const std::vector<TextShadow>& configs);
+
+// 蒙版特效图层, 颜色已解析
+struct MaskEffectLayer
+{
+    MaskEffect config;
+    SkColor color;
+    SkColor highlightColor;
+    SkColor shadowColor;
+};
+
+// 编译蒙版特效, 忽略未知类型
+std::vector<MaskEffectLayer> compileMaskEffects(const std::vector<MaskEffect>& configs);
 
-std::vector<SkPaint> createShadowPaints(const std::vector<TextShadow>& configs);
\ No newline at end of file
+// 将透明度a映射为同一图层叠加count次后的透明度
+sk_sp<SkColorFilter> makeRepeatAlphaFilter(int count);
\ No newline at end of file
@@ -3,9 +3,7 @@
 #include <iostream>
 #include "FntGen.h"
 #include "Editor.h"
-
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
+#include "MaskBlur.h"
 
 const char* templateConfigStr = R"(
 {
@@ -133,12 +131,37 @@ GenerateConfig readConfig(const std::string& filename)
 int main(int argc, char* const argv[]) 
 {
     bool showGUI = false;
+    bool planMode = false;
+    std::string planFileName;
     std::string configFileName;
+
+    // 模糊耗时对比, 不需要配置文件, 在读取配置之前处理
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--bench-blur") == 0)
+        {
+            benchmarkMaskBlur();
+            return EXIT_SUCCESS;
+        }
+    }
+
     if (argc > 1)
     {
         configFileName = argv[1];
-        if (argc > 2 && strcmp(argv[2], "--gui") == 0)
-            showGUI = true;
+        for (int i = 2; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--gui") == 0)
+            {
+                showGUI = true;
+            }
+            else if (strcmp(argv[i], "--plan") == 0)
+            {
+                planMode = true;
+                // 可选的json输出文件
+                if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+                    planFileName = argv[++i];
+            }
+        }
     }
     else
     {
@@ -146,30 +169,21 @@ int main(int argc, char* const argv[])
     }
 
     auto config = readConfig(configFileName);
-    if (showGUI)
+    if (planMode)
+    {
+        // 不进行渲染, 无需初始化opengl
+        FntGen gen;
+        return gen.plan(config, planFileName) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    else if (showGUI)
     {
         Editor editor;
         return editor.run(config);
     }
     else
     {
-        glfwInit();    
-        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
-        GLFWwindow* window = glfwCreateWindow(1, 1, "", nullptr, nullptr);
-        glfwMakeContextCurrent(window);
-
-        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-        {
-            std::cerr << "Failed to initialize GLAD" << std::endl;
-        }
-
-        bool ok = false;
-        {
-            FntGen gen;
-            ok = gen.run(config);
-        }
-        glfwDestroyWindow(window);
-        glfwTerminate();
-        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+        // opengl只在需要GPU渲染时初始化, 无显示设备时使用CPU渲染
+        FntGen gen;
+        return gen.run(config) ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 }
\ No newline at end of file